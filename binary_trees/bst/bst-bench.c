@@ -0,0 +1,117 @@
+/*
+ * Times the BST on the skewed input that degenerates an unbalanced tree:
+ * keys inserted in order, in reverse, and nearly in order (sorted, then
+ * one in a hundred swapped with a random other). For each, and for both
+ * an unbalanced and an AVL tree, it times inserting every key, searching
+ * for every key, an in-order walk, bst_height and bst_free.
+ * Usage: bst-bench [num_elems]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "bst.h"
+
+#define DEFAULT_NUM_ELEMS 20000
+
+static int cmp_int(const void *a, const void *b)
+{
+    int x = *(const int *)a, y = *(const int *)b;
+    return (x > y) - (x < y);
+}
+
+static void sum_int(void *elem, void *aux_data)
+{
+    *(long *)aux_data += *(int *)elem;
+}
+
+static double now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void bench(const char *input, const int *keys, int n,
+                  enum BALANCE balance)
+{
+    bst_t *tree = bst_init(sizeof(int), cmp_int, NULL, balance);
+
+    double start = now();
+    for (int i = 0; i < n; i++)
+    {
+        bst_insert(tree, (void *)&keys[i]);
+    }
+    double insert = now() - start;
+
+    start = now();
+    int found = 0;
+    for (int i = 0; i < n; i++)
+    {
+        found += (bst_search(tree, (void *)&keys[i]) != NULL);
+    }
+    double search = now() - start;
+
+    start = now();
+    long sum = 0;
+    bst_map(tree, IN_ORDER, sum_int, &sum);
+    double walk = now() - start;
+
+    start = now();
+    size_t height = bst_height(tree);
+    double height_time = now() - start;
+
+    start = now();
+    bst_free(tree);
+    double free_time = now() - start;
+
+    if (found != n || sum != (long)n * (n - 1) / 2)
+    {
+        printf("(wrong results)\n");
+    }
+    printf("%-14s %-10s %8zu %10.1f %10.1f %10.1f %10.1f %10.1f\n", input,
+           (balance == AVL)? "AVL" : "unbalanced", height,
+           insert * 1e9 / n, search * 1e9 / n, walk * 1e9 / n,
+           height_time * 1e9 / n, free_time * 1e9 / n);
+}
+
+int main(int argc, const char *argv[])
+{
+    int n = (argc > 1)? atoi(argv[1]) : DEFAULT_NUM_ELEMS;
+    int *keys = malloc(n * sizeof(int));
+    if (keys == NULL)
+    {
+        printf("malloc() failed! Exiting...\n");
+        exit(1);
+    }
+
+    printf("%d keys, ns per key for each operation\n\n", n);
+    printf("%-14s %-10s %8s %10s %10s %10s %10s %10s\n", "input", "tree",
+           "height", "insert", "search", "walk", "height", "free");
+    for (int input = 0; input < 3; input++)
+    {
+        for (int i = 0; i < n; i++)
+        {
+            keys[i] = (input == 1)? n - 1 - i : i;
+        }
+        if (input == 2)
+        {
+            srandom(25);
+            for (int i = 0; i < n / 100; i++)
+            {
+                int a = random() % n, b = random() % n;
+                int tmp = keys[a];
+                keys[a] = keys[b];
+                keys[b] = tmp;
+            }
+        }
+        const char *name = (input == 0)? "sorted" :
+                           (input == 1)? "reversed" : "nearly sorted";
+        bench(name, keys, n, UNBALANCED);
+        bench(name, keys, n, AVL);
+    }
+
+    free(keys);
+    return 0;
+}
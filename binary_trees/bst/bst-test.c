@@ -1,4 +1,5 @@
 #include <assert.h>
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -17,7 +18,7 @@ static void print_int(void *elem, void *unused)
 
 static node_t *build_node(int val)
 {
-    node_t *n = calloc(1, sizeof(node_t));
+    node_t *n = calloc(1, sizeof(node_t) + sizeof(int));
     if (n == NULL)
     {
         printf("Out of memory...\n");
@@ -27,9 +28,171 @@ static node_t *build_node(int val)
     return n;
 }
 
+static void check_in_order(void *elem, void *aux_data)
+{
+    int *prev = aux_data;
+    assert(*prev <= *(int *)elem);
+    *prev = *(int *)elem;
+}
+
+static void check_descending(void *elem, void *aux_data)
+{
+    int *prev = aux_data;
+    assert(*prev >= *(int *)elem);
+    *prev = *(int *)elem;
+}
+
+/* Checks that every node's height is right and, in an AVL tree, that its
+ * subtrees' heights are within one; returns the subtree's height. */
+static int check_balance(node_t *n, bool avl)
+{
+    if (n == NULL)
+    {
+        return 0;
+    }
+    int left = check_balance(n->left_child, avl);
+    int right = check_balance(n->right_child, avl);
+    if (avl)
+    {
+        assert(abs(left - right) <= 1);
+        assert(n->height == 1 + ((left > right)? left : right));
+    }
+    return 1 + ((left > right)? left : right);
+}
+
+static void test_balance(enum BALANCE balance)
+{
+    bool avl = (balance == AVL);
+    printf("Testing %s trees\n", avl? "AVL" : "unbalanced");
+
+    printf("Checking sorted inserts...");
+    bst_t *tree = bst_init(sizeof(int), cmp_int, NULL, balance);
+    int n = 2000;
+    for (int i = 0; i < n; i++)
+    {
+        bst_insert(tree, &i);
+    }
+    check_balance(tree->root, avl);
+    if (avl)
+    {
+        assert(bst_height(tree) <= 16); /* 1.44 log2(2000) */
+    }
+    else
+    {
+        assert(bst_height(tree) == (size_t)n);
+    }
+    for (int i = 0; i < n; i++)
+    {
+        assert(*(int *)bst_search(tree, &i) == i);
+    }
+    printf("OK!\n");
+
+    printf("Checking removals...");
+    int missing = n;
+    assert(!bst_remove(tree, &missing));
+    for (int i = 0; i < n; i += 2)
+    {
+        assert(bst_remove(tree, &i));
+        assert(!bst_remove(tree, &i));
+    }
+    check_balance(tree->root, avl);
+    for (int i = 0; i < n; i++)
+    {
+        assert((bst_search(tree, &i) != NULL) == (i % 2 == 1));
+    }
+    int prev = -1;
+    bst_map(tree, IN_ORDER, check_in_order, &prev);
+    assert(prev == n - 1);
+    printf("OK!\n");
+
+    printf("Checking random inserts and removals, with duplicates...");
+    srandom(24);
+    for (int i = 0; i < 20000; i++)
+    {
+        int elem = (int)(random() % 500);
+        if (random() % 3 == 0)
+        {
+            bst_remove(tree, &elem);
+        }
+        else
+        {
+            bst_insert(tree, &elem);
+        }
+    }
+    check_balance(tree->root, avl);
+    prev = -1;
+    bst_map(tree, IN_ORDER, check_in_order, &prev);
+    bst_free(tree);
+    printf("OK!\n");
+
+    printf("All good with %s trees!\n\n", avl? "AVL" : "unbalanced");
+}
+
+/* Appends each element to the int array that aux_data points into. */
+static void record_int(void *elem, void *aux_data)
+{
+    int **next = aux_data;
+    *(*next)++ = *(int *)elem;
+}
+
+static void test_traversals()
+{
+    printf("Testing traversals\n");
+
+    printf("Checking each order on a small tree...");
+    bst_t *tree = bst_init(sizeof(int), cmp_int, NULL, UNBALANCED);
+    int elems[] = { 4, 2, 6, 1, 3, 5, 7 };
+    for (int i = 0; i < 7; i++)
+    {
+        bst_insert(tree, &elems[i]);
+    }
+    int pre[] = { 4, 2, 1, 3, 6, 5, 7 };
+    int in[] = { 1, 2, 3, 4, 5, 6, 7 };
+    int post[] = { 1, 3, 2, 5, 7, 6, 4 };
+    int seen[7], *next = seen;
+    bst_map(tree, PRE_ORDER, record_int, &next);
+    assert(next == seen + 7 && memcmp(seen, pre, sizeof(pre)) == 0);
+    next = seen;
+    bst_map(tree, IN_ORDER, record_int, &next);
+    assert(next == seen + 7 && memcmp(seen, in, sizeof(in)) == 0);
+    next = seen;
+    bst_map(tree, POST_ORDER, record_int, &next);
+    assert(next == seen + 7 && memcmp(seen, post, sizeof(post)) == 0);
+    assert(bst_height(tree) == 3);
+    bst_free(tree);
+    printf("OK!\n");
+
+    printf("Checking a tree too deep to recurse through...");
+    tree = bst_init(sizeof(int), cmp_int, NULL, UNBALANCED);
+    int n = 1000000;
+    /* A left spine, built by hand, as inserting in order would take
+     * quadratic time. */
+    node_t **link = &tree->root;
+    for (int i = n; i > 0; i--)
+    {
+        *link = calloc(1, sizeof(node_t) + sizeof(int));
+        memcpy((*link)->data, &i, sizeof(int));
+        link = &(*link)->left_child;
+    }
+    assert(bst_height(tree) == (size_t)n);
+    int prev = 0;
+    bst_map(tree, IN_ORDER, check_in_order, &prev);
+    assert(prev == n);
+    bst_map(tree, PRE_ORDER, check_descending, &prev);
+    bst_map(tree, POST_ORDER, check_in_order, &prev);
+    bst_free(tree);
+    printf("OK!\n");
+
+    printf("All good with traversals!\n\n");
+}
+
 int main(int argc, const char *argv[])
 {
-    bst_t *tree = bst_init(sizeof(int), cmp_int, NULL);
+    test_balance(UNBALANCED);
+    test_balance(AVL);
+    test_traversals();
+
+    bst_t *tree = bst_init(sizeof(int), cmp_int, NULL, UNBALANCED);
     assert(tree != NULL);
     assert(tree->root == NULL);
 
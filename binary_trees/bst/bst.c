@@ -9,6 +9,14 @@
 /* Taken from Julie Zelenski, May 2012 */
 #define NOT_YET_IMPLEMENTED printf("%s() not yet implemented!\n", __FUNCTION__); exit(1);
 
+/* An AVL tree of n nodes is under 1.45 log2(n + 2) high, so this covers
+ * any that fits in memory. */
+#define MAX_AVL_HEIGHT 96
+
+/* Traversals keep this many nodes on the C stack before going to the
+ * heap, which only a badly unbalanced tree needs. */
+#define INLINE_STACK_NODES 64
+
 static node_t *build_node(void *elem, size_t elem_size)
 {
     node_t *n = calloc(1, sizeof(node_t) + elem_size);
@@ -21,7 +29,57 @@ static node_t *build_node(void *elem, size_t elem_size)
     return n;
 }
 
-bst_t *bst_init(size_t elem_size, bst_cmp_fn cmp_fn, bst_free_fn free_fn)
+/**
+ * An explicit stack of nodes for the traversals, so that they don't
+ * recurse once per level.
+ */
+struct node_stack
+{
+    node_t **nodes;
+    size_t len;
+    size_t alloc;
+    node_t *inline_nodes[INLINE_STACK_NODES];
+};
+
+static void stack_init(struct node_stack *s)
+{
+    s->nodes = s->inline_nodes;
+    s->len = 0;
+    s->alloc = INLINE_STACK_NODES;
+}
+
+static void stack_push(struct node_stack *s, node_t *n)
+{
+    if (s->len == s->alloc)
+    {
+        s->alloc *= 2;
+        node_t **nodes = (s->nodes == s->inline_nodes)?
+                         malloc(s->alloc * sizeof(node_t *)) :
+                         realloc(s->nodes, s->alloc * sizeof(node_t *));
+        if (nodes == NULL)
+        {
+            printf("malloc() failed! Exiting...\n");
+            exit(1);
+        }
+        if (s->nodes == s->inline_nodes)
+        {
+            memcpy(nodes, s->inline_nodes, sizeof(s->inline_nodes));
+        }
+        s->nodes = nodes;
+    }
+    s->nodes[s->len++] = n;
+}
+
+static void stack_free(struct node_stack *s)
+{
+    if (s->nodes != s->inline_nodes)
+    {
+        free(s->nodes);
+    }
+}
+
+bst_t *bst_init(size_t elem_size, bst_cmp_fn cmp_fn, bst_free_fn free_fn,
+                enum BALANCE balance)
 {
     bst_t *tree = malloc(sizeof(bst_t));
     if (tree == NULL)
@@ -33,124 +91,350 @@ bst_t *bst_init(size_t elem_size, bst_cmp_fn cmp_fn, bst_free_fn free_fn)
     tree->elem_size = elem_size;
     tree->cmp_fn = cmp_fn;
     tree->free_fn = free_fn;
+    tree->balance = balance;
     return tree;
 }
 
+/**
+ * Frees every node under n with no stack at all: whenever the node in
+ * hand has a left child, rotate it right, so the left child comes up and
+ * the tree leans further right; once it has none, free it and move on to
+ * its right. Each rotation puts one more node on the right spine for
+ * good, so this takes O(n) steps.
+ */
 static void free_node(node_t *n, bst_free_fn free_fn)
 {
-    if (n != NULL)
+    while (n != NULL)
     {
-        free_node(n->left_child, free_fn);
-        free_node(n->right_child, free_fn);
+        node_t *left = n->left_child;
+        if (left != NULL)
+        {
+            n->left_child = left->right_child;
+            left->right_child = n;
+            n = left;
+            continue;
+        }
+        node_t *right = n->right_child;
         if (free_fn != NULL)
         {
             free_fn(n->data);
         }
         free(n);
+        n = right;
     }
 }
 
 void bst_free(bst_t *tree)
 {
     free_node(tree->root, tree->free_fn);
+    free(tree);
 }
 
-size_t height(node_t *n, size_t max_height)
+/**
+ * Walks the tree in post-order with an explicit stack. A node stays on the
+ * stack until both its subtrees are done, so the stack always holds the
+ * whole path from the root down to the node in hand, and the height is
+ * just the deepest it gets.
+ */
+static size_t height(node_t *n)
 {
-    if (n == NULL)
+    struct node_stack s;
+    stack_init(&s);
+    size_t max_height = 0;
+    node_t *last = NULL;
+    while (n != NULL || s.len > 0)
+    {
+        for (; n != NULL; n = n->left_child)
+        {
+            stack_push(&s, n);
+        }
+        max_height = MAX(max_height, s.len);
+        node_t *top = s.nodes[s.len - 1];
+        if (top->right_child != NULL && top->right_child != last)
+        {
+            n = top->right_child;
+        }
+        else
+        {
+            s.len--;
+            last = top;
+        }
+    }
+    stack_free(&s);
+    return max_height;
+}
+
+size_t bst_height(bst_t *tree)
+{
+    /* AVL trees keep their heights up to date. */
+    if (tree->balance == AVL)
     {
-        return max_height;
+        return (tree->root == NULL)? 0 : tree->root->height;
     }
+    return height(tree->root);
+}
 
-    return MAX(height(n->left_child, max_height + 1),
-            height(n->right_child, max_height + 1));
+/* The height of an AVL subtree, which is 0 if it's empty. */
+static inline int avl_height(node_t *n)
+{
+    return (n == NULL)? 0 : n->height;
 }
 
-size_t bst_height(bst_t *tree)
+static inline void update_height(node_t *n)
 {
-    return height(tree->root, 1);
+    n->height = 1 + MAX(avl_height(n->left_child),
+                        avl_height(n->right_child));
 }
 
-static node_t *insert(node_t *n, node_t *to_insert, bst_cmp_fn cmp_fn)
+/**
+ * Lifts n's left child l into n's place, with n as l's right child and
+ * l's old right subtree as n's left. The in-order sequence is unchanged.
+ */
+static node_t *rotate_right(node_t *n)
 {
-    if (n == NULL)
+    node_t *l = n->left_child;
+    n->left_child = l->right_child;
+    l->right_child = n;
+    update_height(n);
+    update_height(l);
+    return l;
+}
+
+/* The mirror image of rotate_right. */
+static node_t *rotate_left(node_t *n)
+{
+    node_t *r = n->right_child;
+    n->right_child = r->left_child;
+    r->left_child = n;
+    update_height(n);
+    update_height(r);
+    return r;
+}
+
+/**
+ * Restores the AVL balance of n, whose subtrees are balanced but may
+ * differ in height by two after an insert or remove below it, and returns
+ * the new root of the subtree.
+ */
+static node_t *rebalance(node_t *n)
+{
+    int balance = avl_height(n->left_child) - avl_height(n->right_child);
+    if (balance > 1)
     {
-        return to_insert;
+        /* Left-right: straighten the left subtree out first. */
+        if (avl_height(n->left_child->left_child) <
+            avl_height(n->left_child->right_child))
+        {
+            n->left_child = rotate_left(n->left_child);
+        }
+        return rotate_right(n);
     }
-    int comparison = cmp_fn(to_insert->data, n->data);
-    if (comparison <= 0)
+    if (balance < -1)
     {
-        n->left_child = insert(n->left_child, to_insert, cmp_fn);
+        if (avl_height(n->right_child->right_child) <
+            avl_height(n->right_child->left_child))
+        {
+            n->right_child = rotate_right(n->right_child);
+        }
+        return rotate_left(n);
     }
-    else
+    update_height(n);
+    return n;
+}
+
+/**
+ * Rebalances the AVL subtrees at the links in path, from the last (the
+ * deepest) up, after an insert or remove below them. Once a subtree comes
+ * out the height it was before, nothing above it can have changed.
+ */
+static void rebalance_path(node_t **path[], size_t depth)
+{
+    while (depth > 0)
     {
-        n->right_child = insert(n->right_child, to_insert, cmp_fn);
+        node_t **link = path[--depth];
+        unsigned char old_height = (*link)->height;
+        *link = rebalance(*link);
+        if ((*link)->height == old_height)
+        {
+            break;
+        }
     }
-    return n;
 }
 
 void bst_insert(bst_t *tree, void *elem)
 {
     node_t *to_insert = build_node(elem, tree->elem_size);
-    tree->root = insert(tree->root, to_insert, tree->cmp_fn);
-}
+    bool avl = (tree->balance == AVL);
+    node_t **path[MAX_AVL_HEIGHT];
+    size_t depth = 0;
 
-void bst_remove(bst_t *tree)
-{
-    NOT_YET_IMPLEMENTED
+    /* Walk the link that will point at the new node, rather than the
+     * node that will be its parent, so the root needs no special case. */
+    node_t **link = &tree->root;
+    while (*link != NULL)
+    {
+        if (avl)
+        {
+            path[depth++] = link;
+        }
+        int comparison = tree->cmp_fn(to_insert->data, (*link)->data);
+        link = (comparison <= 0)? &(*link)->left_child
+                                : &(*link)->right_child;
+    }
+    *link = to_insert;
+    if (avl)
+    {
+        to_insert->height = 1;
+        rebalance_path(path, depth);
+    }
 }
 
-static void *search(node_t *n, void *elem, bst_cmp_fn cmp_fn)
+bool bst_remove(bst_t *tree, void *elem)
 {
-    if (n != NULL)
+    bool avl = (tree->balance == AVL);
+    node_t **path[MAX_AVL_HEIGHT];
+    size_t depth = 0;
+
+    node_t **link = &tree->root;
+    int comparison;
+    while (*link != NULL &&
+           (comparison = tree->cmp_fn(elem, (*link)->data)) != 0)
     {
-        int comparison = cmp_fn(elem, n->data);
-        if (comparison < 0)
+        if (avl)
         {
-            return search(n->left_child, elem, cmp_fn);
+            path[depth++] = link;
         }
-        else if (comparison > 0)
+        link = (comparison < 0)? &(*link)->left_child
+                               : &(*link)->right_child;
+    }
+    node_t *n = *link;
+    if (n == NULL)
+    {
+        return false;
+    }
+
+    if (n->right_child == NULL)
+    {
+        *link = n->left_child;
+    }
+    else
+    {
+        /* The successor, the least node on the right, takes n's place. */
+        size_t n_depth = depth;
+        if (avl)
         {
-            return search(n->right_child, elem, cmp_fn);
+            path[depth++] = link;
+        }
+        node_t **succ_link = &n->right_child;
+        while ((*succ_link)->left_child != NULL)
+        {
+            if (avl)
+            {
+                path[depth++] = succ_link;
+            }
+            succ_link = &(*succ_link)->left_child;
+        }
+        node_t *succ = *succ_link;
+        *succ_link = succ->right_child;
+        succ->left_child = n->left_child;
+        succ->right_child = n->right_child;
+        succ->height = n->height;
+        *link = succ;
+        /* The path ran through n, which is going away. */
+        if (avl && depth > n_depth + 1)
+        {
+            path[n_depth + 1] = &succ->right_child;
         }
     }
-    return n;
+
+    if (tree->free_fn != NULL)
+    {
+        tree->free_fn(n->data);
+    }
+    free(n);
+    if (avl)
+    {
+        rebalance_path(path, depth);
+    }
+    return true;
 }
 
 void *bst_search(bst_t *tree, void *elem)
 {
-    return search(tree->root, elem, tree->cmp_fn);
+    node_t *n = tree->root;
+    while (n != NULL)
+    {
+        int comparison = tree->cmp_fn(elem, n->data);
+        if (comparison == 0)
+        {
+            return n->data;
+        }
+        n = (comparison < 0)? n->left_child : n->right_child;
+    }
+    return NULL;
 }
 
 static void map_pre_order(node_t *n, bst_map_fn map_fn, void *aux_data)
 {
-    if (n != NULL)
+    struct node_stack s;
+    stack_init(&s);
+    while (n != NULL)
     {
         map_fn(n->data, aux_data);
-        map_pre_order(n->left_child, map_fn, aux_data);
-        map_pre_order(n->right_child, map_fn, aux_data);
-    } 
+        /* Go left, coming back for the right later. */
+        if (n->right_child != NULL)
+        {
+            stack_push(&s, n->right_child);
+        }
+        n = (n->left_child != NULL)? n->left_child :
+            (s.len > 0)? s.nodes[--s.len] : NULL;
+    }
+    stack_free(&s);
 }
 
 static void map_in_order(node_t *n, bst_map_fn map_fn, void *aux_data)
 {
-    if (n != NULL)
+    struct node_stack s;
+    stack_init(&s);
+    while (n != NULL || s.len > 0)
     {
-        map_in_order(n->left_child, map_fn, aux_data);
+        /* Stack up the left spine, then visit from the bottom. */
+        for (; n != NULL; n = n->left_child)
+        {
+            stack_push(&s, n);
+        }
+        n = s.nodes[--s.len];
         map_fn(n->data, aux_data);
-        map_in_order(n->right_child, map_fn, aux_data);
+        n = n->right_child;
     }
+    stack_free(&s);
 }
 
-    static void
-map_post_order(node_t *n, bst_map_fn map_fn, void *aux_data)
+static void map_post_order(node_t *n, bst_map_fn map_fn, void *aux_data)
 {
-    if (n != NULL)
+    struct node_stack s;
+    stack_init(&s);
+    node_t *last = NULL; /* the node visited last */
+    while (n != NULL || s.len > 0)
     {
-        map_post_order(n->left_child, map_fn, aux_data);
-        map_post_order(n->right_child, map_fn, aux_data);
-        map_fn(n->data, aux_data);
+        for (; n != NULL; n = n->left_child)
+        {
+            stack_push(&s, n);
+        }
+        node_t *top = s.nodes[s.len - 1];
+        /* A node's turn comes once its right subtree is done with. */
+        if (top->right_child != NULL && top->right_child != last)
+        {
+            n = top->right_child;
+        }
+        else
+        {
+            s.len--;
+            map_fn(top->data, aux_data);
+            last = top;
+        }
     }
+    stack_free(&s);
 }
 
 void bst_map(bst_t *tree, enum ORDER traversal_order, bst_map_fn map_fn, void *aux_data)
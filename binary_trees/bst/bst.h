@@ -1,6 +1,7 @@
 #ifndef BST_BST_H_
 #define BST_BST_H_
 
+#include <stdbool.h>
 #include <stdlib.h>
 
 typedef int (*bst_cmp_fn)(const void *a, const void *b);
@@ -9,11 +10,22 @@ typedef void (*bst_map_fn)(void *elem, void *aux_data);
 
 enum ORDER { PRE_ORDER, IN_ORDER, POST_ORDER };
 
+/**
+ * How a tree keeps itself in shape. An UNBALANCED tree takes elements
+ * where they fall, so sorted input degenerates it into a list, with
+ * height n. An AVL tree rotates as it goes to keep the heights of every
+ * node's two subtrees within one of each other, which bounds its height
+ * at about 1.44 log2(n), making insert, search and remove O(log n) in
+ * the worst case.
+ */
+enum BALANCE { UNBALANCED, AVL };
+
 typedef struct node
 {
     struct node *left_child;
     struct node *right_child;
-    char data[];
+    unsigned char height; /* of the subtree, in AVL trees; 0 otherwise */
+    char data[] __attribute__((aligned(sizeof(void *))));
 }
 node_t;
 
@@ -23,15 +35,22 @@ typedef struct bst
     size_t elem_size;
     bst_cmp_fn cmp_fn;
     bst_free_fn free_fn;
+    enum BALANCE balance;
 }
 bst_t;
 
-bst_t *bst_init(size_t elem_size, bst_cmp_fn cmp_fn, bst_free_fn free_fn);
+bst_t *bst_init(size_t elem_size, bst_cmp_fn cmp_fn, bst_free_fn free_fn,
+                enum BALANCE balance);
 void bst_free(bst_t *tree);
 size_t bst_height(bst_t *tree);
 void bst_insert(bst_t *tree, void *elem);
 void *bst_search(bst_t *tree, void *elem);
 void bst_map(bst_t *tree, enum ORDER traversal_order, bst_map_fn map_fn, void *aux_data);
-void bst_remove(bst_t *tree);
+
+/**
+ * Removes an element that compares equal to elem, disposing of it with
+ * free_fn. Returns false if there was none.
+ */
+bool bst_remove(bst_t *tree, void *elem);
 
 #endif /* BST_BST_H_ */
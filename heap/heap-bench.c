@@ -0,0 +1,181 @@
+/*
+ * heap-bench.c
+ * ------------
+ * Author: Nate Hardison
+ *
+ * Times a scheduling queue of timer entries in binary and d-ary heaps.
+ * For each arity it fills a min-heap with num_elems random deadlines,
+ * runs num_elems "hold" operations (pop the earliest entry, reinsert it
+ * a random delay later, as a scheduler does), then drains the heap.
+ * Then it picks the top TOP_K of a stream of num_elems random keys three
+ * ways: inserting them all and popping TOP_K, offering them one by one to
+ * a top-k heap, and offering them in batches.
+ * Usage: heap-bench [num_elems]
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "heap.h"
+
+#define DEFAULT_NUM_ELEMS 10000000
+#define MAX_DELAY (1 << 20)
+#define TOP_K 100
+#define STREAM_BATCH 4096
+
+typedef struct
+{
+    uint64_t deadline;
+    uint64_t id;
+} timer_entry;
+
+/* Earliest deadline first. */
+static int cmp_deadline(const void *a, const void *b)
+{
+    uint64_t x = ((const timer_entry *)a)->deadline;
+    uint64_t y = ((const timer_entry *)b)->deadline;
+    return (x < y) - (x > y);
+}
+
+static double now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static uint64_t next_random(uint64_t *state)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+static void bench(const char *name, size_t arity, size_t num_elems)
+{
+    heap_t *heap = (arity == 2)? heap_init(sizeof(timer_entry), cmp_deadline)
+                   : heap_init_dary(sizeof(timer_entry), cmp_deadline, arity);
+    uint64_t state = 88172645463325252ull;
+
+    double start = now();
+    for (size_t i = 0; i < num_elems; i++)
+    {
+        timer_entry e = { next_random(&state) % ((uint64_t)MAX_DELAY << 4),
+                          i };
+        heap_insert(heap, &e);
+    }
+    double insert = now() - start;
+
+    start = now();
+    for (size_t i = 0; i < num_elems; i++)
+    {
+        timer_entry *e = heap_pop_max(heap);
+        e->deadline += 1 + next_random(&state) % MAX_DELAY;
+        heap_insert(heap, e);
+    }
+    double hold = now() - start;
+
+    start = now();
+    uint64_t last = 0;
+    for (size_t i = 0; i < num_elems; i++)
+    {
+        timer_entry *e = heap_pop_max(heap);
+        if (e->deadline < last) printf("(out of order)\n");
+        last = e->deadline;
+    }
+    double drain = now() - start;
+    heap_free(heap, NULL);
+
+    printf("%-10s %10.1f %10.1f %10.1f\n", name, insert * 1e9 / num_elems,
+           hold * 1e9 / num_elems, drain * 1e9 / num_elems);
+}
+
+static int cmp_key(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+/* Returns the sum of the top TOP_K keys, to check the ways agree. */
+static uint64_t select_top_k(int how, size_t num_elems)
+{
+    heap_t *heap = (how == 0)? heap_init(sizeof(uint64_t), cmp_key)
+                   : heap_init_top_k(sizeof(uint64_t), cmp_key, TOP_K);
+    uint64_t state = 88172645463325252ull;
+    uint64_t batch[STREAM_BATCH];
+    for (size_t i = 0; i < num_elems; i += STREAM_BATCH)
+    {
+        size_t n = (num_elems - i < STREAM_BATCH)? num_elems - i
+                                                 : STREAM_BATCH;
+        for (size_t j = 0; j < n; j++)
+        {
+            batch[j] = next_random(&state);
+        }
+        if (how == 2)
+        {
+            heap_offer_n(heap, batch, n);
+            continue;
+        }
+        for (size_t j = 0; j < n; j++)
+        {
+            if (how == 0)
+            {
+                heap_insert(heap, &batch[j]);
+            }
+            else
+            {
+                heap_offer(heap, &batch[j]);
+            }
+        }
+    }
+    uint64_t top[TOP_K], sum = 0;
+    if (how == 0)
+    {
+        for (size_t i = 0; i < TOP_K && heap_size(heap) > 0; i++)
+        {
+            top[i] = *(uint64_t *)heap_pop_max(heap);
+        }
+    }
+    else
+    {
+        heap_drain_sorted(heap, top);
+    }
+    for (size_t i = 0; i < TOP_K && i < num_elems; i++)
+    {
+        sum += top[i];
+    }
+    heap_free(heap, NULL);
+    return sum;
+}
+
+static void bench_top_k(size_t num_elems)
+{
+    const char *names[] = { "insert all", "heap_offer", "heap_offer_n" };
+    printf("\nTop %d of %zu random keys, ns per key\n\n", TOP_K, num_elems);
+    for (int how = 0; how < 3; how++)
+    {
+        double start = now();
+        uint64_t sum = select_top_k(how, num_elems);
+        double elapsed = now() - start;
+        printf("%-14s %8.2f   (checksum %llx)\n", names[how],
+               elapsed * 1e9 / num_elems, (unsigned long long)sum);
+    }
+}
+
+int main(int argc, const char *argv[])
+{
+    size_t num_elems = (argc > 1)? strtoul(argv[1], NULL, 10)
+                                 : DEFAULT_NUM_ELEMS;
+
+    printf("%zu %zu-byte timer entries, ns per operation\n\n", num_elems,
+           sizeof(timer_entry));
+    printf("%-10s %10s %10s %10s\n", "layout", "insert", "hold", "pop");
+    bench("binary", 2, num_elems);
+    bench("4-ary", 4, num_elems);
+    bench("8-ary", 8, num_elems);
+    bench_top_k(num_elems);
+    return 0;
+}
@@ -0,0 +1,439 @@
+#include <assert.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "heap.h"
+
+static int cmp_int(const void *a, const void *b)
+{
+    int x = *(const int *)a, y = *(const int *)b;
+    return (x > y) - (x < y);
+}
+
+static int cmp_int_reverse(const void *a, const void *b)
+{
+    return cmp_int(b, a);
+}
+
+/* Pops everything, checking that it comes out in order and that there
+ * were n elements. */
+static void drain_in_order(heap_t *heap, size_t n, heap_cmp_fn cmp_fn)
+{
+    assert(heap_size(heap) == n);
+    int prev = 0;
+    for (size_t i = 0; i < n; i++)
+    {
+        int peeked = *(int *)heap_peek(heap);
+        int popped = *(int *)heap_pop_max(heap);
+        assert(popped == peeked);
+        if (i > 0) assert(cmp_fn(&prev, &popped) >= 0);
+        prev = popped;
+        assert(heap_size(heap) == n - i - 1);
+    }
+}
+
+static void test_heap_insert()
+{
+    printf("Testing heap_insert()\n---------------------\n");
+
+    printf("Checking ascending, descending and random input...");
+    size_t n = 10000;
+    for (int pattern = 0; pattern < 3; pattern++)
+    {
+        heap_t *heap = heap_init(sizeof(int), cmp_int);
+        srandom(pattern);
+        for (size_t i = 0; i < n; i++)
+        {
+            int elem = (pattern == 0)? (int)i :
+                       (pattern == 1)? (int)(n - i) : (int)(random() % 100);
+            heap_insert(heap, &elem);
+        }
+        drain_in_order(heap, n, cmp_int);
+        heap_free(heap, NULL);
+    }
+    printf("OK!\n");
+
+    printf("Checking a min-heap...");
+    heap_t *heap = heap_init(sizeof(int), cmp_int_reverse);
+    for (int i = 0; i < 1000; i++)
+    {
+        int elem = (i * 7919) % 1000;
+        heap_insert(heap, &elem);
+    }
+    assert(*(int *)heap_peek(heap) == 0);
+    drain_in_order(heap, 1000, cmp_int_reverse);
+    heap_free(heap, NULL);
+    printf("OK!\n");
+
+    printf("Checking that a popped element can go straight back in...");
+    heap = heap_init(sizeof(int), cmp_int);
+    for (int i = 0; i < 16; i++)
+    {
+        heap_insert(heap, &i);
+    }
+    int *max = heap_pop_max(heap);
+    assert(*max == 15);
+    *max = -1;
+    heap_insert(heap, max);
+    drain_in_order(heap, 16, cmp_int);
+    heap_free(heap, NULL);
+    printf("OK!\n");
+
+    printf("Checking heap_replace_max()...");
+    heap = heap_init_dary(sizeof(int), cmp_int, 4);
+    for (int i = 0; i < 100; i++)
+    {
+        heap_insert(heap, &i);
+    }
+    for (int i = 0; i < 100; i++)
+    {
+        int *top = heap_peek(heap);
+        *top -= 100;
+        heap_replace_max(heap, top);
+    }
+    for (int i = -1; i >= -100; i--)
+    {
+        assert(*(int *)heap_pop_max(heap) == i);
+    }
+    heap_free(heap, NULL);
+    printf("OK!\n");
+
+    printf("All good with heap_insert()!\n\n");
+}
+
+static void test_heap_init_from_array()
+{
+    printf("Testing heap_init_from_array()\n------------------------------\n");
+
+    printf("Checking sizes 0 through 100...");
+    int elems[100];
+    for (size_t n = 0; n <= 100; n++)
+    {
+        for (size_t i = 0; i < n; i++)
+        {
+            elems[i] = (int)((i * 37) % 11);
+        }
+        heap_t *heap = heap_init_from_array(sizeof(int), cmp_int, elems, n);
+        drain_in_order(heap, n, cmp_int);
+        heap_free(heap, NULL);
+    }
+    printf("OK!\n");
+
+    printf("Checking that the heap copies the array...");
+    for (int i = 0; i < 100; i++)
+    {
+        elems[i] = i;
+    }
+    heap_t *heap = heap_init_from_array(sizeof(int), cmp_int, elems, 100);
+    for (int i = 0; i < 100; i++)
+    {
+        assert(elems[i] == i);
+    }
+    printf("OK!\n");
+
+    printf("Checking inserts into a heapified array...");
+    for (int i = 100; i < 1000; i++)
+    {
+        int elem = (i % 2 == 0)? i : -i;
+        heap_insert(heap, &elem);
+    }
+    drain_in_order(heap, 1000, cmp_int);
+    heap_free(heap, NULL);
+    printf("OK!\n");
+
+    printf("All good with heap_init_from_array()!\n\n");
+}
+
+static void test_heap_init_dary()
+{
+    printf("Testing heap_init_dary()\n------------------------\n");
+
+    printf("Checking arities 2 through 16...");
+    size_t n = 10000;
+    for (size_t arity = 2; arity <= 16; arity *= 2)
+    {
+        heap_t *heap = heap_init_dary(sizeof(int), cmp_int, arity);
+        srandom(arity);
+        for (size_t i = 0; i < n; i++)
+        {
+            int elem = (int)(random() % 1000);
+            heap_insert(heap, &elem);
+        }
+        /* Pop half and refill, so sifts run through a heap with a
+         * partial last group of children. */
+        for (size_t i = 0; i < n / 2; i++)
+        {
+            heap_pop_max(heap);
+        }
+        for (size_t i = 0; i < n / 2 - 3; i++)
+        {
+            int elem = (int)(random() % 1000);
+            heap_insert(heap, &elem);
+        }
+        drain_in_order(heap, n - 3, cmp_int);
+        heap_free(heap, NULL);
+    }
+    printf("OK!\n");
+
+    printf("Checking the default arity on odd-sized elements...");
+    char elem[24];
+    memset(elem, 0, sizeof(elem));
+    heap_t *heap = heap_init_dary(sizeof(elem), cmp_int, 0);
+    for (int i = 0; i < 1000; i++)
+    {
+        *(int *)elem = (i * 7919) % 1000;
+        heap_insert(heap, elem);
+    }
+    for (int i = 999; i >= 0; i--)
+    {
+        assert(*(int *)heap_pop_max(heap) == i);
+    }
+    heap_free(heap, NULL);
+    printf("OK!\n");
+
+    printf("All good with heap_init_dary()!\n\n");
+}
+
+/* An entry in an indexed heap: a key, and the handle it was given, to
+ * check that handles keep naming the same entries. */
+typedef struct
+{
+    int key;
+    heap_handle handle;
+} keyed;
+
+static void check_handles(heap_t *heap, keyed *entries, bool *live, size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        if (!live[i]) continue;
+        keyed *e = heap_get(heap, entries[i].handle);
+        assert(e->key == entries[i].key);
+        assert(e->handle == entries[i].handle);
+    }
+}
+
+static void test_heap_init_indexed()
+{
+    printf("Testing heap_init_indexed()\n---------------------------\n");
+
+    for (size_t arity = 2; arity <= 8; arity *= 2)
+    {
+        printf("Checking updates and removals (arity %zu)...", arity);
+        size_t n = 2000;
+        keyed *entries = malloc(n * sizeof(keyed));
+        bool *live = calloc(n, sizeof(bool));
+        assert(entries != NULL && live != NULL);
+        heap_t *heap = heap_init_indexed(sizeof(keyed), cmp_int, arity);
+        srandom(arity);
+        for (size_t i = 0; i < n; i++)
+        {
+            entries[i].key = (int)(random() % 1000);
+            entries[i].handle = heap_insert(heap, &entries[i]);
+            assert(entries[i].handle != HEAP_NO_HANDLE);
+            ((keyed *)heap_get(heap, entries[i].handle))->handle =
+                entries[i].handle;
+            live[i] = true;
+        }
+        check_handles(heap, entries, live, n);
+
+        /* Raise and lower keys, both through a copy and in place. */
+        for (size_t i = 0; i < n; i += 3)
+        {
+            entries[i].key = (int)(random() % 2000) - 500;
+            if (i % 2 == 0)
+            {
+                heap_update_key(heap, entries[i].handle, &entries[i]);
+            }
+            else
+            {
+                keyed *e = heap_get(heap, entries[i].handle);
+                e->key = entries[i].key;
+                heap_update_key(heap, entries[i].handle, e);
+            }
+        }
+        check_handles(heap, entries, live, n);
+
+        size_t size = n;
+        for (size_t i = 1; i < n; i += 5)
+        {
+            keyed *e = heap_remove(heap, entries[i].handle);
+            assert(e->key == entries[i].key);
+            live[i] = false;
+            size--;
+        }
+        check_handles(heap, entries, live, n);
+        assert(heap_size(heap) == size);
+
+        /* Pop the top few, then reinsert them, reusing their handles. */
+        for (int i = 0; i < 10; i++)
+        {
+            keyed *e = heap_pop_max(heap);
+            size_t j = 0;
+            while (!live[j] || entries[j].handle != e->handle) j++;
+            live[j] = false;
+        }
+        for (size_t i = 1; i < 50; i += 5)
+        {
+            entries[i].handle = heap_insert(heap, &entries[i]);
+            ((keyed *)heap_get(heap, entries[i].handle))->handle =
+                entries[i].handle;
+            live[i] = true;
+        }
+        check_handles(heap, entries, live, n);
+        drain_in_order(heap, size, cmp_int);
+        heap_free(heap, NULL);
+        free(entries);
+        free(live);
+        printf("OK!\n");
+    }
+
+    printf("Checking that a plain heap gives no handles...");
+    heap_t *heap = heap_init(sizeof(int), cmp_int);
+    int elem = 1;
+    assert(heap_insert(heap, &elem) == HEAP_NO_HANDLE);
+    heap_free(heap, NULL);
+    printf("OK!\n");
+
+    printf("All good with heap_init_indexed()!\n\n");
+}
+
+static void test_heap_init_top_k()
+{
+    printf("Testing heap_init_top_k()\n-------------------------\n");
+
+    size_t n = 100000;
+    int *stream = malloc(n * sizeof(int));
+    int *sorted = malloc(n * sizeof(int));
+    assert(stream != NULL && sorted != NULL);
+    srandom(22);
+    for (size_t i = 0; i < n; i++)
+    {
+        stream[i] = (int)(random() % 50000);
+    }
+    memcpy(sorted, stream, n * sizeof(int));
+    qsort(sorted, n, sizeof(int), cmp_int_reverse);
+
+    size_t ks[] = { 1, 10, 1000, n, n + 5 };
+    for (size_t batch = 0; batch <= 1; batch++)
+    {
+        printf("Checking the top k of a stream, %s...",
+               batch? "offered in batches" : "offered one by one");
+        for (size_t t = 0; t < sizeof(ks) / sizeof(*ks); t++)
+        {
+            size_t k = ks[t];
+            heap_t *heap = heap_init_top_k(sizeof(int), cmp_int, k);
+            if (batch)
+            {
+                /* Uneven batches, to straddle filter blocks. */
+                for (size_t i = 0; i < n; i += 1000)
+                {
+                    size_t len = (n - i < 1000)? n - i : 1000;
+                    heap_offer_n(heap, stream + i, len / 3);
+                    heap_offer_n(heap, stream + i + len / 3, len - len / 3);
+                }
+            }
+            else
+            {
+                for (size_t i = 0; i < n; i++)
+                {
+                    heap_offer(heap, &stream[i]);
+                }
+            }
+            size_t kept = (k < n)? k : n;
+            assert(heap_size(heap) == kept);
+            assert(*(int *)heap_peek(heap) == sorted[kept - 1]);
+            int *top = malloc(kept * sizeof(int));
+            assert(heap_drain_sorted(heap, top) == kept);
+            assert(memcmp(top, sorted, kept * sizeof(int)) == 0);
+            assert(heap_size(heap) == 0);
+            free(top);
+            heap_free(heap, NULL);
+        }
+        printf("OK!\n");
+    }
+
+    printf("Checking that offers report what they keep...");
+    heap_t *heap = heap_init_top_k(sizeof(int), cmp_int, 2);
+    int elems[] = { 5, 3, 1, 4, 9, 4 };
+    assert(heap_offer(heap, &elems[0]) && heap_offer(heap, &elems[1]));
+    assert(!heap_offer(heap, &elems[2]));
+    assert(heap_offer_n(heap, elems + 3, 3) == 2);
+    int top[2];
+    heap_drain_sorted(heap, top);
+    assert(top[0] == 9 && top[1] == 5);
+    heap_free(heap, NULL);
+    printf("OK!\n");
+
+    printf("Checking a sorted drain of an ordinary heap...");
+    heap = heap_init_from_array(sizeof(int), cmp_int, stream, n);
+    int *drained = malloc(n * sizeof(int));
+    assert(heap_drain_sorted(heap, drained) == n);
+    assert(memcmp(drained, sorted, n * sizeof(int)) == 0);
+    heap_free(heap, NULL);
+    free(drained);
+    printf("OK!\n");
+
+    free(stream);
+    free(sorted);
+    printf("All good with heap_init_top_k()!\n\n");
+}
+
+/* A job that the heap orders by priority, bigger than a word and owning
+ * memory, to exercise elem_size and free_fn. */
+typedef struct
+{
+    int priority;
+    char name[20];
+    char *payload;
+} job;
+
+static int cmp_job(const void *a, const void *b)
+{
+    return cmp_int(&((const job *)a)->priority, &((const job *)b)->priority);
+}
+
+static void free_job(void *elem)
+{
+    free(((job *)elem)->payload);
+}
+
+static void test_heap_free()
+{
+    printf("Testing heap_free()\n-------------------\n");
+
+    printf("Checking that free_fn sees what's left...");
+    heap_t *heap = heap_init(sizeof(job), cmp_job);
+    for (int i = 0; i < 100; i++)
+    {
+        job j = { .priority = i % 10 };
+        snprintf(j.name, sizeof(j.name), "job %d", i);
+        j.payload = strdup(j.name);
+        heap_insert(heap, &j);
+    }
+    for (int i = 0; i < 10; i++)
+    {
+        job *j = heap_pop_max(heap);
+        assert(j->priority == 9);
+        assert(strcmp(j->name, j->payload) == 0);
+        free(j->payload);
+    }
+    assert(((job *)heap_peek(heap))->priority == 8);
+    heap_free(heap, free_job);
+    printf("OK!\n");
+
+    printf("All good with heap_free()!\n\n");
+}
+
+int main(int argc, const char *argv[])
+{
+    test_heap_insert();
+    test_heap_init_from_array();
+    test_heap_init_dary();
+    test_heap_init_indexed();
+    test_heap_init_top_k();
+    test_heap_free();
+    return 0;
+}
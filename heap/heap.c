@@ -1,94 +1,549 @@
 #include "heap.h"
 
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DEFAULT_ALLOCATION 16
+
+#define CACHE_LINE 64
+
+/* heap_offer_n filters this many elements at a time, one bit of a mask
+ * each. */
+#define OFFER_BLOCK 64
+
+/* Bounds on the arity heap_init_dary picks by itself. */
+#define MIN_DEFAULT_ARITY 4
+#define MAX_DEFAULT_ARITY 8
+
 struct heap
 {
     size_t elem_size;
     size_t num_elems;
-    size_t alloc_size;
-    size_t head;
+    size_t alloc_size; /* in elements */
     heap_cmp_fn cmp_fn;
-    vector_t *elems;
+    unsigned int arity_shift; /* log2 of the number of children per node */
+    char *elems;
+    void *block; /* the allocation holding elems, which may start in it */
+    char *scratch; /* holds the element being sifted, elem_size bytes */
+
+    /* For heaps from heap_init_indexed; both are NULL otherwise. */
+    heap_handle *handle_of; /* the handle of each element, alloc_size long */
+    size_t *position; /* where each handle's element is, alloc_size long */
+    heap_handle scratch_handle;
+    heap_handle free_handles; /* released handles, linked through position */
+    size_t num_handles; /* handles ever given out */
+
+    /* For heaps from heap_init_top_k, k; 0 otherwise. A top-k heap is a
+     * min-heap, ordered by cmp_fn reversed. */
+    size_t capacity;
 };
 
-static inline void parent(size_t i)
+static inline size_t parent(const heap_t *heap, size_t i)
 {
-    return (i - 1) / 2;
+    return (i - 1) >> heap->arity_shift;
 }
 
-static inline size_t left_child(size_t i)
+static inline size_t first_child(const heap_t *heap, size_t i)
 {
-    return (i * 2) + 1;
+    return (i << heap->arity_shift) + 1;
 }
 
-static inline size_t right_child(size_t i)
+static inline void *ith_elem(const heap_t *heap, size_t i)
 {
-    return (i + 1) * 2;
+    return heap->elems + (i * heap->elem_size);
 }
 
-heap_t *heap_init(size_t elem_size, heap_cmp_fn cmp_fn)
+/**
+ * Compares two elements by the heap's order: >0 if a belongs above b.
+ */
+static inline int compare(const heap_t *heap, const void *a, const void *b)
+{
+    return (heap->capacity > 0)? heap->cmp_fn(b, a) : heap->cmp_fn(a, b);
+}
+
+/**
+ * The three ways an element moves during a sift: into scratch, from one
+ * slot to another, and out of scratch. In an indexed heap each also moves
+ * the element's handle and records its new position.
+ */
+static inline void load_scratch(heap_t *heap, size_t from)
+{
+    memcpy(heap->scratch, ith_elem(heap, from), heap->elem_size);
+    if (heap->position != NULL) heap->scratch_handle = heap->handle_of[from];
+}
+
+static inline void move_elem(heap_t *heap, size_t to, size_t from)
 {
+    memcpy(ith_elem(heap, to), ith_elem(heap, from), heap->elem_size);
+    if (heap->position != NULL)
+    {
+        heap_handle handle = heap->handle_of[from];
+        heap->handle_of[to] = handle;
+        heap->position[handle] = to;
+    }
+}
+
+static inline void store_scratch(heap_t *heap, size_t to)
+{
+    memcpy(ith_elem(heap, to), heap->scratch, heap->elem_size);
+    if (heap->position != NULL)
+    {
+        heap->handle_of[to] = heap->scratch_handle;
+        heap->position[heap->scratch_handle] = to;
+    }
+}
+
+/**
+ * Resizes one of an indexed heap's side tables to alloc_size entries.
+ */
+static void *resize_table(void *table, size_t alloc_size, size_t entry_size,
+                          const char *caller)
+{
+    if (alloc_size > SIZE_MAX / entry_size)
+    {
+        fprintf(stderr, "error: %s(): Heap too large\n", caller);
+        exit(1);
+    }
+    table = realloc(table, alloc_size * entry_size);
+    if (table == NULL)
+    {
+        fprintf(stderr, "error: %s(): Out of heap memory\n", caller);
+        exit(1);
+    }
+    return table;
+}
+
+/**
+ * Points elems at new space for alloc_size elements, moving any that are
+ * already in the heap. The children of node i are elements
+ * (i << arity_shift) + 1 onwards, so the space is laid out with element 1
+ * on a cache line boundary: when the children of a node fill a cache line
+ * (or a whole number of them), every sift-down step reads exactly one
+ * group of lines rather than straddling two.
+ */
+static void allocate(heap_t *heap, size_t alloc_size, const char *caller)
+{
+    size_t elem_size = heap->elem_size;
+    if (alloc_size > (SIZE_MAX - CACHE_LINE) / elem_size)
+    {
+        fprintf(stderr, "error: %s(): Heap too large\n", caller);
+        exit(1);
+    }
+    void *block;
+    if (posix_memalign(&block, CACHE_LINE,
+                       alloc_size * elem_size + CACHE_LINE) != 0)
+    {
+        fprintf(stderr, "error: %s(): Out of heap memory\n", caller);
+        exit(1);
+    }
+    char *elems = (char *)block + (CACHE_LINE - elem_size % CACHE_LINE)
+                                  % CACHE_LINE;
+    if (heap->num_elems > 0)
+    {
+        memcpy(elems, heap->elems, heap->num_elems * elem_size);
+    }
+    free(heap->block);
+    heap->block = block;
+    heap->elems = elems;
+    heap->alloc_size = alloc_size;
+    if (heap->position != NULL)
+    {
+        heap->handle_of = resize_table(heap->handle_of, alloc_size,
+                                       sizeof(heap_handle), caller);
+        heap->position = resize_table(heap->position, alloc_size,
+                                      sizeof(size_t), caller);
+    }
+}
+
+static heap_t *new_heap(size_t elem_size, heap_cmp_fn cmp_fn, size_t arity,
+                        bool indexed, size_t alloc_size)
+{
+    assert(elem_size > 0);
+    assert(cmp_fn != NULL);
+    assert(arity >= 2 && (arity & (arity - 1)) == 0);
     heap_t *heap = calloc(1, sizeof(heap_t));
     if (heap == NULL)
     {
-        printf("Out of memory\n");
+        fprintf(stderr, "error: heap_init(): Out of heap memory\n");
         exit(1);
     }
-
+    heap->elem_size = elem_size;
     heap->cmp_fn = cmp_fn;
+    while ((1u << heap->arity_shift) < arity) heap->arity_shift++;
+    if (indexed)
+    {
+        /* A placeholder that marks the heap indexed; allocate sizes it. */
+        heap->position = resize_table(NULL, 1, sizeof(size_t), "heap_init");
+        heap->free_handles = HEAP_NO_HANDLE;
+    }
+    allocate(heap, (alloc_size < DEFAULT_ALLOCATION)? DEFAULT_ALLOCATION
+                                                    : alloc_size,
+             "heap_init");
+    heap->scratch = malloc(elem_size);
+    if (heap->scratch == NULL)
+    {
+        fprintf(stderr, "error: heap_init(): Out of heap memory\n");
+        exit(1);
+    }
+    return heap;
+}
 
-    heap->elems = vector_init();
-    if (heap->elems == NULL)
+/**
+ * Doubles the space for elements.
+ */
+static void grow(heap_t *heap)
+{
+    if (heap->alloc_size > SIZE_MAX / 2)
     {
+        fprintf(stderr, "error: grow(): Heap too large\n");
+        exit(1);
+    }
+    allocate(heap, 2 * heap->alloc_size, "grow");
+}
 
+/**
+ * Moves the element in scratch down from position i, among the first n
+ * elements, to where it belongs. Rather than swapping it with a child at
+ * every level, it leaves a hole: each greater child moves up into the
+ * hole, and the element is written once into wherever the hole ends up.
+ */
+static void sift_down(heap_t *heap, size_t i, size_t n)
+{
+    size_t arity = (size_t)1 << heap->arity_shift;
+    size_t child;
+    while ((child = first_child(heap, i)) < n)
+    {
+        size_t end = (n - child < arity)? n : child + arity;
+        /* Pick the greatest child with a select rather than a branch, as
+         * which one wins is a coin toss the predictor can't learn. */
+        size_t greatest = child;
+        for (size_t c = child + 1; c < end; c++)
+        {
+            greatest = (compare(heap, ith_elem(heap, c),
+                                ith_elem(heap, greatest)) > 0)?
+                       c : greatest;
+        }
+        char *greater = ith_elem(heap, greatest);
+        if (compare(heap, greater, heap->scratch) <= 0) break;
+        move_elem(heap, i, greatest);
+        i = greatest;
+    }
+    store_scratch(heap, i);
+}
 
+/**
+ * The same as sift_down, but moving the element in scratch up from i.
+ */
+static void sift_up(heap_t *heap, size_t i)
+{
+    while (i > 0)
+    {
+        size_t above = parent(heap, i);
+        if (compare(heap, heap->scratch, ith_elem(heap, above)) <= 0) break;
+        move_elem(heap, i, above);
+        i = above;
     }
+    store_scratch(heap, i);
+}
 
+/**
+ * Sifts the element in scratch from position i, which it has just been
+ * put into in place of another, whichever way it needs to go.
+ */
+static void sift(heap_t *heap, size_t i)
+{
+    if (i > 0 &&
+        compare(heap, heap->scratch, ith_elem(heap, parent(heap, i))) > 0)
+    {
+        sift_up(heap, i);
+    }
+    else
+    {
+        sift_down(heap, i, heap->num_elems);
+    }
+}
+
+static heap_handle new_handle(heap_t *heap)
+{
+    heap_handle handle = heap->free_handles;
+    if (handle != HEAP_NO_HANDLE)
+    {
+        heap->free_handles = heap->position[handle];
+        return handle;
+    }
+    /* There are never more live handles than elements, and elems has room
+     * for the new one, so this stays within the tables. */
+    return heap->num_handles++;
+}
+
+static void release_handle(heap_t *heap, heap_handle handle)
+{
+    heap->position[handle] = heap->free_handles;
+    heap->free_handles = handle;
+}
+
+/**
+ * Returns the position of the element with the given live handle.
+ */
+static size_t position_of(const heap_t *heap, heap_handle handle)
+{
+    assert(heap->position != NULL);
+    assert(handle < heap->num_handles);
+    size_t i = heap->position[handle];
+    assert(i < heap->num_elems && heap->handle_of[i] == handle);
+    return i;
+}
+
+heap_t *heap_init(size_t elem_size, heap_cmp_fn cmp_fn)
+{
+    return new_heap(elem_size, cmp_fn, 2, false, DEFAULT_ALLOCATION);
+}
+
+heap_t *heap_init_dary(size_t elem_size, heap_cmp_fn cmp_fn, size_t arity)
+{
+    if (arity == 0)
+    {
+        arity = MIN_DEFAULT_ARITY;
+        while (arity < MAX_DEFAULT_ARITY && 2 * arity * elem_size <= CACHE_LINE)
+        {
+            arity *= 2;
+        }
+    }
+    return new_heap(elem_size, cmp_fn, arity, false, DEFAULT_ALLOCATION);
+}
+
+heap_t *heap_init_indexed(size_t elem_size, heap_cmp_fn cmp_fn,
+                          size_t arity)
+{
+    return new_heap(elem_size, cmp_fn, (arity == 0)? 2 : arity, true,
+                    DEFAULT_ALLOCATION);
+}
+
+heap_t *heap_init_top_k(size_t elem_size, heap_cmp_fn cmp_fn, size_t k)
+{
+    assert(k > 0);
+    heap_t *heap = new_heap(elem_size, cmp_fn, 2, false, k);
+    heap->capacity = k;
+    return heap;
+}
+
+heap_t *heap_init_from_array(size_t elem_size, heap_cmp_fn cmp_fn,
+                             const void *elems, size_t n)
+{
+    assert(elems != NULL || n == 0);
+    heap_t *heap = new_heap(elem_size, cmp_fn, 2, false, n);
+    if (n > 0) memcpy(heap->elems, elems, n * elem_size);
+    heap->num_elems = n;
+
+    /* Floyd: sift down every internal node, from the last one back to the
+     * root, so each sifts into subtrees that are already heaps. Most
+     * nodes are near the bottom and sift only a level or two, which makes
+     * the whole thing O(n). */
+    for (size_t i = (n > 1)? parent(heap, n - 1) + 1 : 0; i > 0; i--)
+    {
+        load_scratch(heap, i - 1);
+        sift_down(heap, i - 1, n);
+    }
     return heap;
 }
 
 void heap_free(heap_t *heap, heap_free_fn free_fn)
 {
-    if (heap->elems != NULL)
+    assert(heap != NULL);
+    if (free_fn != NULL)
     {
-        vector_free(heap->elems, free_fn);
+        for (size_t i = 0; i < heap->num_elems; i++)
+        {
+            free_fn(ith_elem(heap, i));
+        }
     }
+    free(heap->block);
+    free(heap->scratch);
+    free(heap->handle_of);
+    free(heap->position);
     free(heap);
 }
 
-void *pop_max(heap_t *heap)
+void *heap_pop_max(heap_t *heap)
 {
-    
+    assert(heap != NULL);
+    assert(heap->num_elems > 0);
+    size_t last = --heap->num_elems;
+    if (heap->position != NULL) release_handle(heap, heap->handle_of[0]);
+    if (last > 0)
+    {
+        /* The last element goes to the root's place and sifts down from
+         * there, and the max takes the slot it vacated, just past the end
+         * of the heap, for the caller to read. */
+        load_scratch(heap, last);
+        memcpy(ith_elem(heap, last), ith_elem(heap, 0), heap->elem_size);
+        sift_down(heap, 0, last);
+    }
+    return ith_elem(heap, last);
+}
+
+void heap_replace_max(heap_t *heap, const void *elem)
+{
+    assert(heap != NULL);
+    assert(elem != NULL);
+    assert(heap->num_elems > 0);
+    /* elem may be the max itself, from heap_peek. */
+    memcpy(heap->scratch, elem, heap->elem_size);
+    if (heap->position != NULL) heap->scratch_handle = heap->handle_of[0];
+    sift_down(heap, 0, heap->num_elems);
 }
 
-void heap_insert(heap_t *heap, void *elem)
+void *heap_peek(const heap_t *heap)
 {
-    vector_append(heap->elems, elem);
-    heapify_up(heap); 
+    assert(heap != NULL);
+    assert(heap->num_elems > 0);
+    return ith_elem(heap, 0);
 }
 
-static void heapify_up(heap_t *heap)
+heap_handle heap_insert(heap_t *heap, const void *elem)
 {
-    // we always inserted at the end
-    size_t elem_index = vector_length(heap->elems) - 1;
-    while (elem_index > 0)
+    assert(heap != NULL);
+    assert(elem != NULL);
+    assert(heap->capacity == 0);
+    /* Copy elem first: it may be a popped element, inside elems. */
+    memcpy(heap->scratch, elem, heap->elem_size);
+    if (heap->num_elems == heap->alloc_size) grow(heap);
+    heap_handle handle = HEAP_NO_HANDLE;
+    if (heap->position != NULL)
     {
-        size_t parent_index = parent(elem_index);
-        if (heap->cmp_fn() <= 0) break;
-        
-        elem_index = parent_index;
+        handle = new_handle(heap);
+        heap->scratch_handle = handle;
     }
-        
-    void *elem = vector_nth(heap->elems, elem_index);
-    void *parent = parent_index(elem_index);
-    if (heap->cmp_fn(elem, parent(elem_index)) > 0)
+    sift_up(heap, heap->num_elems++);
+    return handle;
+}
+
+void *heap_get(const heap_t *heap, heap_handle handle)
+{
+    assert(heap != NULL);
+    return ith_elem(heap, position_of(heap, handle));
+}
+
+void heap_update_key(heap_t *heap, heap_handle handle, const void *elem)
+{
+    assert(heap != NULL);
+    assert(elem != NULL);
+    size_t i = position_of(heap, handle);
+    /* elem may be the one in the heap, from heap_get. */
+    memcpy(heap->scratch, elem, heap->elem_size);
+    heap->scratch_handle = handle;
+    sift(heap, i);
+}
+
+void *heap_remove(heap_t *heap, heap_handle handle)
+{
+    assert(heap != NULL);
+    size_t i = position_of(heap, handle);
+    size_t last = --heap->num_elems;
+    release_handle(heap, handle);
+    if (i != last)
     {
-        swap(elem, parent);
-    while (heap->cmp_fn(elem, parent(elem_index)) > 0);
+        /* As in heap_pop_max, the last element fills the hole and the
+         * removed one lands just past the end. */
+        load_scratch(heap, last);
+        memcpy(ith_elem(heap, last), ith_elem(heap, i), heap->elem_size);
+        sift(heap, i);
+    }
+    return ith_elem(heap, last);
+}
 
+bool heap_offer(heap_t *heap, const void *elem)
+{
+    assert(heap != NULL);
+    assert(elem != NULL);
+    assert(heap->capacity > 0);
+    if (heap->num_elems < heap->capacity)
+    {
+        memcpy(heap->scratch, elem, heap->elem_size);
+        sift_up(heap, heap->num_elems++);
+        return true;
+    }
+    /* The root is the least of the k kept: the one to beat. */
+    if (heap->cmp_fn(elem, ith_elem(heap, 0)) <= 0) return false;
+    memcpy(heap->scratch, elem, heap->elem_size);
+    sift_down(heap, 0, heap->num_elems);
+    return true;
 }
 
-static void heapify_down(heap_t *heap)
+size_t heap_offer_n(heap_t *heap, const void *elems, size_t n)
 {
+    assert(heap != NULL);
+    assert(elems != NULL || n == 0);
+    assert(heap->capacity > 0);
+    const char *elem = elems;
+    size_t i = 0, kept = 0;
+    for (; i < n && heap->num_elems < heap->capacity; i++)
+    {
+        kept += heap_offer(heap, elem + i * heap->elem_size);
+    }
 
+    /* Once the heap is full, most of a long stream loses to the threshold.
+     * Filter a block at a time against the threshold as it stood at the
+     * start of the block, building a mask of the elements that beat it
+     * with no branch per element, then offer only those. The threshold
+     * only rises, so an element that loses to the old one loses to every
+     * later one too. */
+    while (i < n)
+    {
+        size_t block = (n - i < OFFER_BLOCK)? n - i : OFFER_BLOCK;
+        const char *threshold = ith_elem(heap, 0);
+        uint64_t mask = 0;
+        for (size_t j = 0; j < block; j++)
+        {
+            const char *e = elem + (i + j) * heap->elem_size;
+            mask |= (uint64_t)(heap->cmp_fn(e, threshold) > 0) << j;
+        }
+        /* threshold is the root, which the offers below may overwrite. */
+        while (mask != 0)
+        {
+            size_t j = __builtin_ctzll(mask);
+            mask &= mask - 1;
+            kept += heap_offer(heap, elem + (i + j) * heap->elem_size);
+        }
+        i += block;
+    }
+    return kept;
 }
 
+size_t heap_drain_sorted(heap_t *heap, void *out)
+{
+    assert(heap != NULL);
+    assert(out != NULL || heap->num_elems == 0);
+    /* Popping everything is a heapsort in place: each pop leaves its
+     * element just past the shrinking heap, so the buffer ends up in the
+     * reverse of pop order. A top-k heap pops least first, so its buffer
+     * is already greatest first; a max-heap's needs reversing. */
+    size_t n = heap->num_elems;
+    while (heap->num_elems > 0)
+    {
+        heap_pop_max(heap);
+    }
+    if (heap->capacity > 0)
+    {
+        if (n > 0) memcpy(out, heap->elems, n * heap->elem_size);
+    }
+    else
+    {
+        for (size_t i = 0; i < n; i++)
+        {
+            memcpy((char *)out + i * heap->elem_size,
+                   ith_elem(heap, n - 1 - i), heap->elem_size);
+        }
+    }
+    return n;
+}
+
+size_t heap_size(const heap_t *heap)
+{
+    assert(heap != NULL);
+    return heap->num_elems;
+}
@@ -1,14 +1,153 @@
 #ifndef _HEAP_H
 #define _HEAP_H
 
-typedef int (*heap_cmp_fn)(void *a, void *b);
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef int (*heap_cmp_fn)(const void *a, const void *b);
 typedef void (*heap_free_fn)(void *elem);
 
+/**
+ * Names an element in an indexed heap for as long as it stays in the
+ * heap, however it moves around. Once the element is popped or removed,
+ * the handle may be reused for a later insert.
+ */
+typedef size_t heap_handle;
+
+#define HEAP_NO_HANDLE ((heap_handle)-1)
+
+/**
+ * A max-heap of elem_size elements, stored back to back in one buffer in
+ * the usual implicit layout (the children of element i are 2i+1 and 2i+2).
+ * cmp_fn orders them; pass one that reverses the order for a min-heap.
+ */
 typedef struct heap heap_t;
 
 heap_t *heap_init(size_t elem_size, heap_cmp_fn cmp_fn);
+
+/**
+ * Initializes a d-ary heap: each node has arity children rather than two,
+ * so the heap is log2(arity) times shallower. The children of a node sit
+ * side by side, aligned to a cache line, so a sift-down reads one line
+ * per level where a binary heap of a large queue takes a cache miss at
+ * nearly every level. Pops compare more children per level but walk far
+ * fewer levels; inserts only ever compare with the parent, so they get
+ * cheaper outright.
+ *
+ * arity must be a power of two. Passing 0 picks as many children as fit
+ * in a cache line, but no fewer than 4 and no more than 8.
+ */
+heap_t *heap_init_dary(size_t elem_size, heap_cmp_fn cmp_fn, size_t arity);
+
+/**
+ * Initializes a heap whose elements can be reached, changed and removed
+ * after they go in, through the handle heap_insert returns. The heap keeps
+ * each element's position up to date as sifts move it, which costs two
+ * side tables and a little work per move, so only indexed heaps do it.
+ * This is what a priority that changes in place (a decrease-key in
+ * Dijkstra's algorithm, a rescheduled job) needs in place of inserting a
+ * duplicate and skipping the stale one later.
+ *
+ * arity is as for heap_init_dary, except that 0 means a binary heap.
+ */
+heap_t *heap_init_indexed(size_t elem_size, heap_cmp_fn cmp_fn,
+                          size_t arity);
+
+/**
+ * Initializes a top-k heap, which keeps only the k greatest elements
+ * offered to it (see heap_offer), in O(k) memory however long the stream
+ * of offers. It's a min-heap of at most k elements, so heap_peek and
+ * heap_pop_max see the least of the elements kept, the one a new element
+ * has to beat. Use heap_offer rather than heap_insert.
+ */
+heap_t *heap_init_top_k(size_t elem_size, heap_cmp_fn cmp_fn, size_t k);
+
+/**
+ * Builds a heap out of a copy of the n elements stored back to back at
+ * elems, in O(n) time (Floyd's algorithm) rather than the O(n log n) of n
+ * calls to heap_insert.
+ */
+heap_t *heap_init_from_array(size_t elem_size, heap_cmp_fn cmp_fn,
+                             const void *elems, size_t n);
+
+/**
+ * Disposes of the heap, calling free_fn (unless it's NULL) on each of the
+ * elements still in it.
+ */
 void heap_free(heap_t *heap, heap_free_fn free_fn);
+
+/**
+ * Removes the greatest element and returns a pointer to it. The element
+ * becomes the caller's; the pointer stays good until the next insert.
+ * The heap must not be empty.
+ */
 void *heap_pop_max(heap_t *heap);
-void heap_insert(heap_t *heap, void *elem);
+
+/**
+ * Replaces the greatest element by a copy of elem, which then sifts down
+ * to its place: what heap_pop_max and heap_insert do together, for about
+ * half the compares. In an indexed heap, elem takes over the old max's
+ * handle. The heap must not be empty.
+ */
+void heap_replace_max(heap_t *heap, const void *elem);
+
+/**
+ * Returns the greatest element, leaving it in the heap. The heap must not
+ * be empty.
+ */
+void *heap_peek(const heap_t *heap);
+
+/**
+ * Adds a copy of elem to the heap. In an indexed heap, returns the new
+ * element's handle; otherwise returns HEAP_NO_HANDLE.
+ */
+heap_handle heap_insert(heap_t *heap, const void *elem);
+
+/**
+ * Returns the element with the given handle, in an indexed heap. Change it
+ * only through heap_update_key.
+ */
+void *heap_get(const heap_t *heap, heap_handle handle);
+
+/**
+ * Replaces the element with the given handle by a copy of elem (which may
+ * be the pointer heap_get returned, changed in place) and moves it to its
+ * new place in the heap, in O(log n). The handle stays the same.
+ */
+void heap_update_key(heap_t *heap, heap_handle handle, const void *elem);
+
+/**
+ * Removes the element with the given handle, in O(log n), and returns a
+ * pointer to it, which is good until the next insert. As with
+ * heap_pop_max, the element becomes the caller's.
+ */
+void *heap_remove(heap_t *heap, heap_handle handle);
+
+/**
+ * Offers a copy of elem to a top-k heap. Until the heap holds k elements
+ * it takes everything; after that, an element is turned away with a
+ * single compare unless it beats the least one kept, which it replaces.
+ * Returns whether elem was kept.
+ */
+bool heap_offer(heap_t *heap, const void *elem);
+
+/**
+ * Offers the n elements stored back to back at elems to a top-k heap, as
+ * heap_offer would one by one, and returns how many were kept (though a
+ * later one may have pushed an earlier one back out). Elements are first
+ * checked against the current threshold a block at a time, without a
+ * branch per element, so that the losers, most of a long stream, cost
+ * little more than the compare.
+ */
+size_t heap_offer_n(heap_t *heap, const void *elems, size_t n);
+
+/**
+ * Empties the heap into out, which must have room for heap_size elements,
+ * greatest first, and returns how many it wrote. This works on any heap;
+ * for a top-k heap it's how to get the k greatest, in order.
+ */
+size_t heap_drain_sorted(heap_t *heap, void *out);
+
+size_t heap_size(const heap_t *heap);
 
 #endif /* _HEAP_H */
@@ -0,0 +1,171 @@
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "merge.h"
+
+static int cmp_int(const void *a, const void *b)
+{
+    int x = *(const int *)a, y = *(const int *)b;
+    return (x > y) - (x < y);
+}
+
+/* A run held in an array, for merges that don't touch files. */
+struct array_run
+{
+    const int *elems;
+    size_t len, pos;
+};
+
+static bool read_array(void *source, void *elem)
+{
+    struct array_run *run = source;
+    if (run->pos == run->len) return false;
+    *(int *)elem = run->elems[run->pos++];
+    return true;
+}
+
+/* An element with a tag, to check that equal keys keep run order. */
+typedef struct
+{
+    int key;
+    int run;
+} tagged;
+
+struct tagged_run
+{
+    int key, run, left;
+};
+
+static bool read_tagged(void *source, void *elem)
+{
+    struct tagged_run *r = source;
+    if (r->left == 0) return false;
+    r->left--;
+    *(tagged *)elem = (tagged){ r->key, r->run };
+    return true;
+}
+
+static void test_merge_next()
+{
+    printf("Testing merge_next()\n--------------------\n");
+
+    printf("Checking a merge of runs of assorted lengths...");
+    size_t k = 100;
+    struct array_run *runs = calloc(k, sizeof(struct array_run));
+    void **sources = malloc(k * sizeof(void *));
+    size_t total = 0;
+    for (size_t i = 0; i < k; i++)
+    {
+        size_t len = (i * 37) % 250;
+        int *elems = malloc(len * sizeof(int) + 1);
+        for (size_t j = 0; j < len; j++)
+        {
+            elems[j] = (int)(j * (i % 7 + 1) + i % 13);
+        }
+        runs[i] = (struct array_run){ elems, len, 0 };
+        sources[i] = &runs[i];
+        total += len;
+    }
+    merge_t *merge = merge_init(sizeof(int), cmp_int, read_array, sources, k);
+    size_t count = 0;
+    int prev = 0;
+    for (int *elem; (elem = merge_next(merge)) != NULL; count++)
+    {
+        if (count > 0) assert(prev <= *elem);
+        prev = *elem;
+    }
+    assert(count == total);
+    assert(merge_next(merge) == NULL);
+    merge_free(merge);
+    for (size_t i = 0; i < k; i++)
+    {
+        free((int *)runs[i].elems);
+    }
+    printf("OK!\n");
+
+    printf("Checking that equal elements keep the order of their runs...");
+    struct tagged_run tagged_runs[5];
+    for (int i = 0; i < 5; i++)
+    {
+        tagged_runs[i] = (struct tagged_run){ 7, i, 3 };
+        sources[i] = &tagged_runs[i];
+    }
+    merge = merge_init(sizeof(tagged), cmp_int, read_tagged, sources, 5);
+    for (int i = 0; i < 15; i++)
+    {
+        tagged *t = merge_next(merge);
+        assert(t->key == 7 && t->run == i / 3);
+    }
+    assert(merge_next(merge) == NULL);
+    merge_free(merge);
+    printf("OK!\n");
+
+    printf("Checking a merge of no runs...");
+    merge = merge_init(sizeof(int), cmp_int, read_array, NULL, 0);
+    assert(merge_next(merge) == NULL);
+    merge_free(merge);
+    printf("OK!\n");
+
+    free(runs);
+    free(sources);
+    printf("All good with merge_next()!\n\n");
+}
+
+/* Sorts n random ints in a file with the given budget and checks the
+ * result against qsort. */
+static void check_sort_file(size_t n, size_t mem_budget)
+{
+    int *elems = malloc(n * sizeof(int) + 1);
+    srandom(n);
+    for (size_t i = 0; i < n; i++)
+    {
+        elems[i] = (int)(random() % 100000) - 50000;
+    }
+    FILE *in = tmpfile(), *out = tmpfile();
+    assert(in != NULL && out != NULL);
+    assert(fwrite(elems, sizeof(int), n, in) == n);
+    rewind(in);
+    merge_sort_file(in, out, sizeof(int), cmp_int, mem_budget);
+
+    qsort(elems, n, sizeof(int), cmp_int);
+    rewind(out);
+    int *sorted = malloc(n * sizeof(int) + sizeof(int));
+    assert(fread(sorted, sizeof(int), n + 1, out) == n);
+    assert(memcmp(sorted, elems, n * sizeof(int)) == 0);
+    fclose(in);
+    fclose(out);
+    free(elems);
+    free(sorted);
+}
+
+static void test_merge_sort_file()
+{
+    printf("Testing merge_sort_file()\n-------------------------\n");
+
+    printf("Checking input that fits in the budget...");
+    check_sort_file(0, 1 << 20);
+    check_sort_file(1000, 1 << 20);
+    printf("OK!\n");
+
+    printf("Checking input spilled to runs and merged in one pass...");
+    check_sort_file(200000, 256 * 1024);
+    check_sort_file(65536, 65536 * sizeof(int));
+    printf("OK!\n");
+
+    printf("Checking input with too many runs for one pass...");
+    check_sort_file(300000, 4096);
+    check_sort_file(10001, 3);
+    printf("OK!\n");
+
+    printf("All good with merge_sort_file()!\n\n");
+}
+
+int main(int argc, const char *argv[])
+{
+    test_merge_next();
+    test_merge_sort_file();
+    return 0;
+}
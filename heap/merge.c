@@ -0,0 +1,298 @@
+#include "merge.h"
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Runs are not read or written in blocks smaller than this, as a merge
+ * spends its time seeking between runs otherwise. */
+#define MIN_IO_BUFFER (64 * 1024)
+
+/**
+ * What the merge keeps in its heap for each run: the run's next element
+ * and where it came from. The heap's cmp_fn gets nothing but the two
+ * entries, so each carries the merge's cmp_fn too.
+ */
+typedef struct
+{
+    heap_cmp_fn cmp_fn;
+    size_t source;
+    char elem[];
+} entry;
+
+struct merge
+{
+    size_t elem_size;
+    merge_read_fn read_fn;
+    void **sources;
+    heap_t *heap; /* of entries, least on top */
+    entry *next; /* where the next entry is built */
+    char *out; /* the element merge_next returns */
+};
+
+/* The least element, then the earliest run, goes on top. */
+static int cmp_entry(const void *a, const void *b)
+{
+    const entry *x = a, *y = b;
+    int cmp = x->cmp_fn(y->elem, x->elem);
+    if (cmp != 0) return cmp;
+    return (x->source < y->source) - (x->source > y->source);
+}
+
+static void *checked_malloc(size_t size, const char *caller)
+{
+    void *ptr = malloc(size);
+    if (ptr == NULL)
+    {
+        fprintf(stderr, "error: %s(): Out of heap memory\n", caller);
+        exit(1);
+    }
+    return ptr;
+}
+
+merge_t *merge_init(size_t elem_size, heap_cmp_fn cmp_fn,
+                    merge_read_fn read_fn, void *sources[], size_t k)
+{
+    assert(cmp_fn != NULL && read_fn != NULL);
+    assert(sources != NULL || k == 0);
+    merge_t *merge = checked_malloc(sizeof(merge_t), "merge_init");
+    merge->elem_size = elem_size;
+    merge->read_fn = read_fn;
+    merge->sources = checked_malloc(k * sizeof(void *) + 1, "merge_init");
+    if (k > 0) memcpy(merge->sources, sources, k * sizeof(void *));
+
+    /* Rounded up to keep the next entry's pointers aligned. */
+    size_t entry_size = sizeof(entry) + elem_size;
+    entry_size = (entry_size + sizeof(entry) - 1) / sizeof(entry)
+                 * sizeof(entry);
+    merge->next = checked_malloc(entry_size, "merge_init");
+    merge->out = checked_malloc(elem_size, "merge_init");
+
+    /* Prime the heap with the first element of each run, all at once. */
+    char *firsts = checked_malloc(k * entry_size + 1, "merge_init");
+    size_t n = 0;
+    for (size_t i = 0; i < k; i++)
+    {
+        entry *e = (entry *)(firsts + n * entry_size);
+        if (!read_fn(sources[i], e->elem)) continue;
+        e->cmp_fn = cmp_fn;
+        e->source = i;
+        n++;
+    }
+    merge->heap = heap_init_from_array(entry_size, cmp_entry, firsts, n);
+    merge->next->cmp_fn = cmp_fn;
+    free(firsts);
+    return merge;
+}
+
+void *merge_next(merge_t *merge)
+{
+    assert(merge != NULL);
+    if (heap_size(merge->heap) == 0) return NULL;
+    entry *top = heap_peek(merge->heap);
+    memcpy(merge->out, top->elem, merge->elem_size);
+    /* The next element of the same run takes the top's place, sifting
+     * down once, or the run is done and drops out. */
+    merge->next->source = top->source;
+    if (merge->read_fn(merge->sources[top->source], merge->next->elem))
+    {
+        heap_replace_max(merge->heap, merge->next);
+    }
+    else
+    {
+        heap_pop_max(merge->heap);
+    }
+    return merge->out;
+}
+
+void merge_free(merge_t *merge)
+{
+    assert(merge != NULL);
+    heap_free(merge->heap, NULL);
+    free(merge->sources);
+    free(merge->next);
+    free(merge->out);
+    free(merge);
+}
+
+/**
+ * A run in a file, read sequentially through a buffer of its own.
+ */
+struct run
+{
+    FILE *file;
+    size_t elem_size;
+    char *buffer;
+    size_t buffer_size; /* in bytes, a multiple of elem_size */
+    size_t pos, len;
+};
+
+static void open_run(struct run *run, FILE *file, size_t elem_size,
+                     size_t buffer_size)
+{
+    run->file = file;
+    run->elem_size = elem_size;
+    run->buffer_size = buffer_size;
+    run->buffer = checked_malloc(buffer_size, "open_run");
+    run->pos = run->len = 0;
+    rewind(file);
+}
+
+static bool read_run(void *source, void *elem)
+{
+    struct run *run = source;
+    if (run->pos == run->len)
+    {
+        run->len = fread(run->buffer, 1, run->buffer_size, run->file);
+        run->pos = 0;
+        if (ferror(run->file))
+        {
+            fprintf(stderr, "error: read_run(): Can't read run\n");
+            exit(1);
+        }
+        if (run->len < run->elem_size) return false;
+    }
+    memcpy(elem, run->buffer + run->pos, run->elem_size);
+    run->pos += run->elem_size;
+    return true;
+}
+
+static void write_all(FILE *file, const void *data, size_t size,
+                      const char *caller)
+{
+    if (fwrite(data, 1, size, file) != size)
+    {
+        fprintf(stderr, "error: %s(): Can't write\n", caller);
+        exit(1);
+    }
+}
+
+static FILE *new_run_file(void)
+{
+    FILE *file = tmpfile();
+    if (file == NULL)
+    {
+        fprintf(stderr, "error: new_run_file(): Can't create temp file\n");
+        exit(1);
+    }
+    return file;
+}
+
+/**
+ * Merges the k run files in files into out, splitting buffer_size bytes
+ * of buffers between them and the output.
+ */
+static void merge_files(FILE *files[], size_t k, FILE *out, size_t elem_size,
+                        heap_cmp_fn cmp_fn, size_t buffer_size)
+{
+    size_t run_buffer = buffer_size / (k + 1) / elem_size * elem_size;
+    if (run_buffer < elem_size) run_buffer = elem_size;
+    struct run *runs = checked_malloc(k * sizeof(struct run) + 1,
+                                      "merge_files");
+    void **sources = checked_malloc(k * sizeof(void *) + 1, "merge_files");
+    for (size_t i = 0; i < k; i++)
+    {
+        open_run(&runs[i], files[i], elem_size, run_buffer);
+        sources[i] = &runs[i];
+    }
+
+    char *out_buffer = checked_malloc(run_buffer, "merge_files");
+    size_t out_len = 0;
+    merge_t *merge = merge_init(elem_size, cmp_fn, read_run, sources, k);
+    for (void *elem; (elem = merge_next(merge)) != NULL; )
+    {
+        if (out_len == run_buffer)
+        {
+            write_all(out, out_buffer, out_len, "merge_files");
+            out_len = 0;
+        }
+        memcpy(out_buffer + out_len, elem, elem_size);
+        out_len += elem_size;
+    }
+    write_all(out, out_buffer, out_len, "merge_files");
+    merge_free(merge);
+
+    for (size_t i = 0; i < k; i++)
+    {
+        free(runs[i].buffer);
+    }
+    free(out_buffer);
+    free(sources);
+    free(runs);
+}
+
+void merge_sort_file(FILE *in, FILE *out, size_t elem_size,
+                     heap_cmp_fn cmp_fn, size_t mem_budget)
+{
+    assert(in != NULL && out != NULL);
+    assert(elem_size > 0 && cmp_fn != NULL);
+    if (mem_budget < 2 * elem_size) mem_budget = 2 * elem_size;
+
+    /* Spill sorted runs of as many elements as the budget holds. */
+    size_t run_elems = mem_budget / elem_size;
+    char *chunk = checked_malloc(run_elems * elem_size, "merge_sort_file");
+    FILE **files = NULL;
+    size_t num_files = 0, alloc_files = 0;
+    for (;;)
+    {
+        size_t n = fread(chunk, elem_size, run_elems, in);
+        if (ferror(in))
+        {
+            fprintf(stderr, "error: merge_sort_file(): Can't read input\n");
+            exit(1);
+        }
+        if (n == 0) break;
+        qsort(chunk, n, elem_size, cmp_fn);
+        if (num_files == 0 && n < run_elems)
+        {
+            /* It all fit in memory: no runs needed. */
+            write_all(out, chunk, n * elem_size, "merge_sort_file");
+            free(chunk);
+            return;
+        }
+        if (num_files == alloc_files)
+        {
+            alloc_files = (alloc_files == 0)? 16 : 2 * alloc_files;
+            files = realloc(files, alloc_files * sizeof(FILE *));
+            if (files == NULL)
+            {
+                fprintf(stderr, "error: merge_sort_file(): "
+                        "Out of heap memory\n");
+                exit(1);
+            }
+        }
+        files[num_files] = new_run_file();
+        write_all(files[num_files++], chunk, n * elem_size,
+                  "merge_sort_file");
+        if (n < run_elems) break;
+    }
+    free(chunk);
+
+    /* Merge at most fan_in runs at a time, so each still gets a buffer
+     * of MIN_IO_BUFFER, until one merge can finish the job. */
+    size_t fan_in = mem_budget / MIN_IO_BUFFER;
+    fan_in = (fan_in > 3)? fan_in - 1 : 2;
+    while (num_files > fan_in)
+    {
+        size_t merged = 0;
+        for (size_t i = 0; i < num_files; i += fan_in)
+        {
+            size_t k = (num_files - i < fan_in)? num_files - i : fan_in;
+            FILE *run = new_run_file();
+            merge_files(files + i, k, run, elem_size, cmp_fn, mem_budget);
+            for (size_t j = i; j < i + k; j++)
+            {
+                fclose(files[j]);
+            }
+            files[merged++] = run;
+        }
+        num_files = merged;
+    }
+    merge_files(files, num_files, out, elem_size, cmp_fn, mem_budget);
+    for (size_t i = 0; i < num_files; i++)
+    {
+        fclose(files[i]);
+    }
+    free(files);
+}
@@ -0,0 +1,54 @@
+#ifndef _MERGE_H
+#define _MERGE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#include "heap.h"
+
+/**
+ * Reads the next element of a sorted run from source into elem; returns
+ * false once the run is exhausted.
+ */
+typedef bool (*merge_read_fn)(void *source, void *elem);
+
+/**
+ * A streaming k-way merge of runs that are each sorted ascending by
+ * cmp_fn. It holds one element per run in a heap, so it needs O(k)
+ * memory however long the runs, and each element out costs O(log k)
+ * compares. Elements that compare equal come out in the order of their
+ * runs, so the merge is stable.
+ */
+typedef struct merge merge_t;
+
+/**
+ * Initializes a merge of the k runs in sources, each read with read_fn.
+ * The sources belong to the caller, and must outlive the merge.
+ */
+merge_t *merge_init(size_t elem_size, heap_cmp_fn cmp_fn,
+                    merge_read_fn read_fn, void *sources[], size_t k);
+
+/**
+ * Returns the next element in sorted order, or NULL once every run is
+ * exhausted. The pointer is good until the next call.
+ */
+void *merge_next(merge_t *merge);
+
+void merge_free(merge_t *merge);
+
+/**
+ * Sorts the file in, a sequence of elem_size-byte elements, into out by
+ * cmp_fn, holding no more than about mem_budget bytes in memory however
+ * big the input. It reads the input a budget at a time, sorts each piece
+ * and spills it to a temporary file as a run, then merges the runs with
+ * large sequential reads. If there are too many runs to give each a
+ * useful read buffer within the budget, it merges them a batch at a time
+ * into longer runs first. Like qsort, which sorts the runs, it isn't
+ * stable. Both files should be opened in binary mode; in is read from
+ * its current position to the end.
+ */
+void merge_sort_file(FILE *in, FILE *out, size_t elem_size,
+                     heap_cmp_fn cmp_fn, size_t mem_budget);
+
+#endif /* _MERGE_H */
@@ -0,0 +1,325 @@
+/*
+ * multi-queue-bench.c
+ * -------------------
+ * Author: Nate Hardison
+ *
+ * Pits a multi-queue against a single heap behind a mutex as a shared
+ * work queue. The queue starts with PREFILL items, and then every thread
+ * repeatedly pops an item and inserts a new one with a random key. For
+ * 1, 2, 4... up to max_threads threads it reports throughput, and for the
+ * multi-queue also the rank error of its pops: how many items in the
+ * queue had a greater key than the one popped (always 0 for one heap).
+ *
+ * Rank error comes from a second run that logs every operation with a
+ * global sequence number and replays the log afterward. An insert is
+ * numbered just before it starts and a pop just after it returns, so an
+ * item counts as present for a little longer than it really was, and the
+ * figures are an upper bound.
+ * Usage: multi-queue-bench [max_threads] [ops_per_thread]
+ */
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "heap.h"
+#include "multi-queue.h"
+
+#define DEFAULT_MAX_THREADS 8
+#define DEFAULT_OPS_PER_THREAD 1000000
+#define QUALITY_OPS_PER_THREAD 100000
+#define PREFILL (1 << 16)
+#define KEY_BITS 20
+
+typedef struct
+{
+    uint64_t key;
+    uint64_t id;
+} item;
+
+/* One logged operation, for the rank error replay. */
+typedef struct
+{
+    uint64_t seq;
+    uint64_t key;
+    bool pop;
+} event;
+
+struct worker
+{
+    pthread_t thread;
+    multi_queue_t *mq; /* NULL for the locked heap */
+    size_t ops;
+    uint64_t seed;
+    event *log; /* 2 * ops events, or NULL if not logging */
+};
+
+static heap_t *locked_heap;
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static uint64_t clock_seq;
+
+static int cmp_item(const void *a, const void *b)
+{
+    uint64_t x = ((const item *)a)->key, y = ((const item *)b)->key;
+    return (x > y) - (x < y);
+}
+
+static int cmp_event(const void *a, const void *b)
+{
+    uint64_t x = ((const event *)a)->seq, y = ((const event *)b)->seq;
+    return (x > y) - (x < y);
+}
+
+static double now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static uint64_t next_random(uint64_t *state)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+static void insert(struct worker *w, uint64_t key, uint64_t id)
+{
+    if (w->mq != NULL)
+    {
+        multi_queue_insert(w->mq, key, &id);
+    }
+    else
+    {
+        item it = { key, id };
+        pthread_mutex_lock(&lock);
+        heap_insert(locked_heap, &it);
+        pthread_mutex_unlock(&lock);
+    }
+}
+
+static bool pop(struct worker *w, uint64_t *key)
+{
+    uint64_t id;
+    if (w->mq != NULL) return multi_queue_pop(w->mq, key, &id);
+    pthread_mutex_lock(&lock);
+    bool popped = heap_size(locked_heap) > 0;
+    if (popped) *key = ((item *)heap_pop_max(locked_heap))->key;
+    pthread_mutex_unlock(&lock);
+    return popped;
+}
+
+static void *work(void *aux_data)
+{
+    struct worker *w = aux_data;
+    event *log = w->log;
+    for (size_t i = 0; i < w->ops; i++)
+    {
+        uint64_t key;
+        if (pop(w, &key) && log != NULL)
+        {
+            *log++ = (event){ __atomic_fetch_add(&clock_seq, 1,
+                                                 __ATOMIC_RELAXED),
+                              key, true };
+        }
+        key = next_random(&w->seed) >> (64 - KEY_BITS);
+        if (log != NULL)
+        {
+            *log++ = (event){ __atomic_fetch_add(&clock_seq, 1,
+                                                 __ATOMIC_RELAXED),
+                              key, false };
+        }
+        insert(w, key, i);
+    }
+    if (log != NULL) log->seq = UINT64_MAX; /* end of the log */
+    return NULL;
+}
+
+/* A Fenwick tree over keys counts the items present with each key. */
+static void fenwick_add(long *tree, uint64_t key, long delta)
+{
+    for (size_t i = key + 1; i <= (1 << KEY_BITS); i += i & -i)
+    {
+        tree[i] += delta;
+    }
+}
+
+/* The number of items present with keys up to key. */
+static long fenwick_count(const long *tree, uint64_t key)
+{
+    long count = 0;
+    for (size_t i = key + 1; i > 0; i -= i & -i)
+    {
+        count += tree[i];
+    }
+    return count;
+}
+
+/**
+ * Runs num_threads workers of ops each on mq (or on the locked heap if mq
+ * is NULL) and returns the seconds it took. With logs, each worker logs
+ * to its own, and prefill_keys gets the keys the queue started with.
+ */
+static double run(multi_queue_t *mq, int num_threads, size_t ops,
+                  event **logs, uint64_t *prefill_keys)
+{
+    uint64_t seed = 88172645463325252ull;
+    clock_seq = 0;
+    for (uint64_t i = 0; i < PREFILL; i++)
+    {
+        struct worker w = { .mq = mq };
+        uint64_t key = next_random(&seed) >> (64 - KEY_BITS);
+        if (prefill_keys != NULL) prefill_keys[i] = key;
+        insert(&w, key, i);
+    }
+
+    struct worker workers[num_threads];
+    double start = now();
+    for (int i = 0; i < num_threads; i++)
+    {
+        workers[i] = (struct worker){ .mq = mq, .ops = ops, .seed = i + 1,
+                                      .log = (logs != NULL)? logs[i]
+                                                           : NULL };
+        if (pthread_create(&workers[i].thread, NULL, work, &workers[i]) != 0)
+        {
+            fprintf(stderr, "error: run(): Can't create thread\n");
+            exit(1);
+        }
+    }
+    for (int i = 0; i < num_threads; i++)
+    {
+        pthread_join(workers[i].thread, NULL);
+    }
+    return now() - start;
+}
+
+/**
+ * Replays the logs of a run, in sequence order, and reports the mean and
+ * worst rank error of its pops.
+ */
+static void rank_error(event **logs, int num_threads,
+                       const uint64_t *prefill_keys, double *mean,
+                       long *worst)
+{
+    size_t num_events = 0;
+    for (int i = 0; i < num_threads; i++)
+    {
+        for (event *e = logs[i]; e->seq != UINT64_MAX; e++) num_events++;
+    }
+    event *events = malloc(num_events * sizeof(event));
+    long *tree = calloc((1 << KEY_BITS) + 1, sizeof(long));
+    if (events == NULL || tree == NULL)
+    {
+        fprintf(stderr, "error: rank_error(): Out of heap memory\n");
+        exit(1);
+    }
+    size_t n = 0;
+    for (int i = 0; i < num_threads; i++)
+    {
+        for (event *e = logs[i]; e->seq != UINT64_MAX; e++) events[n++] = *e;
+    }
+    qsort(events, num_events, sizeof(event), cmp_event);
+
+    for (size_t i = 0; i < PREFILL; i++)
+    {
+        fenwick_add(tree, prefill_keys[i], 1);
+    }
+    long present = PREFILL, total = 0, pops = 0;
+    *worst = 0;
+    for (size_t i = 0; i < num_events; i++)
+    {
+        if (events[i].pop)
+        {
+            long greater = present - fenwick_count(tree, events[i].key);
+            total += greater;
+            if (greater > *worst) *worst = greater;
+            pops++;
+            fenwick_add(tree, events[i].key, -1);
+            present--;
+        }
+        else
+        {
+            fenwick_add(tree, events[i].key, 1);
+            present++;
+        }
+    }
+    *mean = (pops > 0)? (double)total / pops : 0;
+    free(events);
+    free(tree);
+}
+
+static void bench(const char *name, size_t per_thread, int num_threads,
+                  size_t ops)
+{
+    multi_queue_t *mq = NULL;
+    if (per_thread > 0)
+    {
+        mq = multi_queue_init(sizeof(uint64_t), per_thread * num_threads);
+    }
+    else
+    {
+        locked_heap = heap_init(sizeof(item), cmp_item);
+    }
+    double elapsed = run(mq, num_threads, ops, NULL, NULL);
+    double mops = num_threads * ops * 2 / elapsed / 1e6;
+    if (mq == NULL)
+    {
+        heap_free(locked_heap, NULL);
+        printf("%-16s %8d %10.2f %12s %10s\n", name, num_threads, mops, "0",
+               "0");
+        return;
+    }
+    multi_queue_free(mq, NULL);
+
+    size_t quality_ops = (ops < QUALITY_OPS_PER_THREAD)?
+                         ops : QUALITY_OPS_PER_THREAD;
+    event *logs[num_threads];
+    uint64_t *prefill_keys = malloc(PREFILL * sizeof(uint64_t));
+    for (int i = 0; i < num_threads; i++)
+    {
+        logs[i] = malloc((2 * quality_ops + 1) * sizeof(event));
+        if (logs[i] == NULL || prefill_keys == NULL)
+        {
+            fprintf(stderr, "error: bench(): Out of heap memory\n");
+            exit(1);
+        }
+    }
+    mq = multi_queue_init(sizeof(uint64_t), per_thread * num_threads);
+    run(mq, num_threads, quality_ops, logs, prefill_keys);
+    multi_queue_free(mq, NULL);
+
+    double mean;
+    long worst;
+    rank_error(logs, num_threads, prefill_keys, &mean, &worst);
+    for (int i = 0; i < num_threads; i++)
+    {
+        free(logs[i]);
+    }
+    free(prefill_keys);
+    printf("%-16s %8d %10.2f %12.2f %10ld\n", name, num_threads, mops, mean,
+           worst);
+}
+
+int main(int argc, const char *argv[])
+{
+    int max_threads = (argc > 1)? atoi(argv[1]) : DEFAULT_MAX_THREADS;
+    size_t ops = (argc > 2)? strtoul(argv[2], NULL, 10)
+                           : DEFAULT_OPS_PER_THREAD;
+
+    printf("%zu pop+insert pairs per thread on %d prefilled items\n\n", ops,
+           PREFILL);
+    printf("%-16s %8s %10s %12s %10s\n", "queue", "threads", "Mops/s",
+           "mean rank", "max rank");
+    for (int threads = 1; threads <= max_threads; threads *= 2)
+    {
+        bench("heap + mutex", 0, threads, ops);
+        bench("multi-queue c=2", 2, threads, ops);
+        bench("multi-queue c=4", 4, threads, ops);
+    }
+    return 0;
+}
@@ -0,0 +1,152 @@
+#include <assert.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "multi-queue.h"
+
+#define NUM_THREADS 8
+#define OPS_PER_THREAD 20000
+
+static void test_multi_queue_pop()
+{
+    printf("Testing multi_queue_pop()\n-------------------------\n");
+
+    printf("Checking that one queue pops in order...");
+    multi_queue_t *mq = multi_queue_init(sizeof(int), 1);
+    for (int i = 0; i < 1000; i++)
+    {
+        int elem = (i * 7919) % 1000;
+        multi_queue_insert(mq, (uint64_t)elem * 3, &elem);
+    }
+    for (int i = 999; i >= 0; i--)
+    {
+        uint64_t key;
+        int elem;
+        assert(multi_queue_pop(mq, &key, &elem));
+        assert(elem == i && key == (uint64_t)i * 3);
+    }
+    int elem;
+    assert(!multi_queue_pop(mq, NULL, &elem));
+    multi_queue_free(mq, NULL);
+    printf("OK!\n");
+
+    printf("Checking that many queues give back every element...");
+    mq = multi_queue_init(sizeof(int), 16);
+    size_t n = 10000;
+    bool *seen = calloc(n, sizeof(bool));
+    assert(seen != NULL);
+    for (size_t i = 0; i < n; i++)
+    {
+        int elem = (int)i;
+        multi_queue_insert(mq, i % 100, &elem);
+    }
+    assert(multi_queue_size(mq) == n);
+    uint64_t key;
+    while (multi_queue_pop(mq, &key, &elem))
+    {
+        assert(!seen[elem] && key == (uint64_t)elem % 100);
+        seen[elem] = true;
+    }
+    for (size_t i = 0; i < n; i++)
+    {
+        assert(seen[i]);
+    }
+    assert(multi_queue_size(mq) == 0);
+    multi_queue_free(mq, NULL);
+    free(seen);
+    printf("OK!\n");
+
+    printf("All good with multi_queue_pop()!\n\n");
+}
+
+struct worker
+{
+    pthread_t thread;
+    multi_queue_t *mq;
+    unsigned int seed;
+    long sum; /* of the values inserted, less those popped */
+};
+
+static void *work(void *aux_data)
+{
+    struct worker *w = aux_data;
+    for (long i = 0; i < OPS_PER_THREAD; i++)
+    {
+        long value = rand_r(&w->seed);
+        if (value % 2 == 0)
+        {
+            multi_queue_insert(w->mq, value % 1000, &value);
+            w->sum += value;
+        }
+        else if (multi_queue_pop(w->mq, NULL, &value))
+        {
+            w->sum -= value;
+        }
+    }
+    return NULL;
+}
+
+static void test_multi_queue_threads()
+{
+    printf("Testing multi_queue threads\n---------------------------\n");
+
+    printf("Checking %d threads inserting and popping at once...",
+           NUM_THREADS);
+    multi_queue_t *mq = multi_queue_init(sizeof(long), 2 * NUM_THREADS);
+    struct worker workers[NUM_THREADS];
+    for (int i = 0; i < NUM_THREADS; i++)
+    {
+        workers[i] = (struct worker){ .mq = mq, .seed = i + 1 };
+        pthread_create(&workers[i].thread, NULL, work, &workers[i]);
+    }
+    long sum = 0;
+    for (int i = 0; i < NUM_THREADS; i++)
+    {
+        pthread_join(workers[i].thread, NULL);
+        sum += workers[i].sum;
+    }
+    long value;
+    while (multi_queue_pop(mq, NULL, &value))
+    {
+        sum -= value;
+    }
+    assert(sum == 0);
+    multi_queue_free(mq, NULL);
+    printf("OK!\n");
+
+    printf("All good with multi_queue threads!\n\n");
+}
+
+static void free_string(void *elem)
+{
+    free(*(char **)elem);
+}
+
+static void test_multi_queue_free()
+{
+    printf("Testing multi_queue_free()\n--------------------------\n");
+
+    printf("Checking that free_fn sees what's left...");
+    multi_queue_t *mq = multi_queue_init(sizeof(char *), 0);
+    for (uint64_t key = 0; key < 100; key++)
+    {
+        char *name = strdup("work item");
+        multi_queue_insert(mq, key, &name);
+    }
+    multi_queue_free(mq, free_string);
+    printf("OK!\n");
+
+    printf("All good with multi_queue_free()!\n\n");
+}
+
+int main(int argc, const char *argv[])
+{
+    test_multi_queue_pop();
+    test_multi_queue_threads();
+    test_multi_queue_free();
+    return 0;
+}
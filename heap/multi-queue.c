@@ -0,0 +1,209 @@
+#include "multi-queue.h"
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define CACHE_LINE 64
+
+/* A pop that keeps drawing empty heaps gives up on chance after this many
+ * tries and looks through all of them. */
+#define MAX_RANDOM_TRIES 16
+
+/* Entries in the heaps are the key, then the element, padded to keep the
+ * next key aligned. */
+#define ENTRY_ALIGN sizeof(uint64_t)
+#define ROUND_UP(x, a) (((x) + (a) - 1) / (a) * (a))
+
+/**
+ * One of the heaps, with its lock and a copy of its top key that others
+ * read without taking the lock, each on a cache line of its own so threads
+ * working on neighboring heaps don't contend for the line.
+ */
+struct queue
+{
+    pthread_mutex_t lock;
+    heap_t *heap;
+    uint64_t top; /* the greatest key in heap, if nonempty */
+    bool nonempty;
+} __attribute__((aligned(CACHE_LINE)));
+
+struct multi_queue
+{
+    size_t elem_size;
+    size_t entry_size;
+    size_t num_queues;
+    struct queue *queues;
+    struct
+    {
+        size_t count;
+    } __attribute__((aligned(CACHE_LINE))) size;
+};
+
+static __thread uint64_t seed;
+
+static size_t random_queue(const multi_queue_t *mq)
+{
+    if (seed == 0) seed = (uint64_t)(uintptr_t)&seed | 1;
+    seed ^= seed << 13;
+    seed ^= seed >> 7;
+    seed ^= seed << 17;
+    return seed % mq->num_queues;
+}
+
+static int cmp_entry(const void *a, const void *b)
+{
+    uint64_t x, y;
+    memcpy(&x, a, sizeof(x));
+    memcpy(&y, b, sizeof(y));
+    return (x > y) - (x < y);
+}
+
+/**
+ * Refreshes the cached top of a queue whose lock we hold.
+ */
+static void update_top(struct queue *q)
+{
+    bool nonempty = heap_size(q->heap) > 0;
+    if (nonempty)
+    {
+        uint64_t top;
+        memcpy(&top, heap_peek(q->heap), sizeof(top));
+        __atomic_store_n(&q->top, top, __ATOMIC_RELAXED);
+    }
+    __atomic_store_n(&q->nonempty, nonempty, __ATOMIC_RELAXED);
+}
+
+/**
+ * Pops the top of a queue whose lock we hold into key and elem; false if
+ * it turned out to be empty.
+ */
+static bool pop_locked(multi_queue_t *mq, struct queue *q, uint64_t *key,
+                       void *elem)
+{
+    if (heap_size(q->heap) == 0) return false;
+    char *entry = heap_pop_max(q->heap);
+    if (key != NULL) memcpy(key, entry, sizeof(*key));
+    memcpy(elem, entry + sizeof(uint64_t), mq->elem_size);
+    update_top(q);
+    __atomic_fetch_sub(&mq->size.count, 1, __ATOMIC_RELAXED);
+    return true;
+}
+
+multi_queue_t *multi_queue_init(size_t elem_size, size_t num_queues)
+{
+    if (num_queues == 0)
+    {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        num_queues = MULTI_QUEUE_DEFAULT_FACTOR * ((cpus > 0)? cpus : 1);
+    }
+    multi_queue_t *mq;
+    if (posix_memalign((void **)&mq, CACHE_LINE, sizeof(multi_queue_t)) != 0
+        || posix_memalign((void **)&mq->queues, CACHE_LINE,
+                          num_queues * sizeof(struct queue)) != 0)
+    {
+        fprintf(stderr, "error: multi_queue_init(): Out of heap memory\n");
+        exit(1);
+    }
+    mq->elem_size = elem_size;
+    mq->entry_size = ROUND_UP(sizeof(uint64_t) + elem_size, ENTRY_ALIGN);
+    mq->num_queues = num_queues;
+    mq->size.count = 0;
+    for (size_t i = 0; i < num_queues; i++)
+    {
+        struct queue *q = &mq->queues[i];
+        pthread_mutex_init(&q->lock, NULL);
+        q->heap = heap_init(mq->entry_size, cmp_entry);
+        q->top = 0;
+        q->nonempty = false;
+    }
+    return mq;
+}
+
+void multi_queue_free(multi_queue_t *mq, heap_free_fn free_fn)
+{
+    assert(mq != NULL);
+    for (size_t i = 0; i < mq->num_queues; i++)
+    {
+        struct queue *q = &mq->queues[i];
+        if (free_fn != NULL)
+        {
+            while (heap_size(q->heap) > 0)
+            {
+                free_fn((char *)heap_pop_max(q->heap) + sizeof(uint64_t));
+            }
+        }
+        heap_free(q->heap, NULL);
+        pthread_mutex_destroy(&q->lock);
+    }
+    free(mq->queues);
+    free(mq);
+}
+
+void multi_queue_insert(multi_queue_t *mq, uint64_t key, const void *elem)
+{
+    assert(mq != NULL);
+    assert(elem != NULL);
+    /* Build the entry on the stack, outside the lock. */
+    char entry[mq->entry_size];
+    memcpy(entry, &key, sizeof(key));
+    memcpy(entry + sizeof(uint64_t), elem, mq->elem_size);
+
+    /* Skip past heaps that another thread holds rather than queue up. */
+    struct queue *q = &mq->queues[random_queue(mq)];
+    while (pthread_mutex_trylock(&q->lock) != 0)
+    {
+        q = &mq->queues[random_queue(mq)];
+    }
+    heap_insert(q->heap, entry);
+    update_top(q);
+    __atomic_fetch_add(&mq->size.count, 1, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&q->lock);
+}
+
+bool multi_queue_pop(multi_queue_t *mq, uint64_t *key, void *elem)
+{
+    assert(mq != NULL);
+    assert(elem != NULL);
+    for (int tries = 0; tries < MAX_RANDOM_TRIES; tries++)
+    {
+        if (multi_queue_size(mq) == 0) return false;
+        struct queue *a = &mq->queues[random_queue(mq)];
+        struct queue *b = &mq->queues[random_queue(mq)];
+        /* The cached tops may be stale; they only steer the choice. */
+        bool a_nonempty = __atomic_load_n(&a->nonempty, __ATOMIC_RELAXED);
+        bool b_nonempty = __atomic_load_n(&b->nonempty, __ATOMIC_RELAXED);
+        if (!a_nonempty && !b_nonempty) continue;
+        if (!a_nonempty ||
+            (b_nonempty && __atomic_load_n(&b->top, __ATOMIC_RELAXED) >
+                           __atomic_load_n(&a->top, __ATOMIC_RELAXED)))
+        {
+            a = b;
+        }
+        if (pthread_mutex_trylock(&a->lock) != 0) continue;
+        bool popped = pop_locked(mq, a, key, elem);
+        pthread_mutex_unlock(&a->lock);
+        if (popped) return true;
+    }
+
+    /* Nearly empty: take anything, from the first heap that has it. */
+    for (size_t i = 0; i < mq->num_queues; i++)
+    {
+        struct queue *q = &mq->queues[i];
+        if (!__atomic_load_n(&q->nonempty, __ATOMIC_RELAXED)) continue;
+        pthread_mutex_lock(&q->lock);
+        bool popped = pop_locked(mq, q, key, elem);
+        pthread_mutex_unlock(&q->lock);
+        if (popped) return true;
+    }
+    return false;
+}
+
+size_t multi_queue_size(const multi_queue_t *mq)
+{
+    assert(mq != NULL);
+    return __atomic_load_n(&mq->size.count, __ATOMIC_RELAXED);
+}
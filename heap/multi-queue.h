@@ -0,0 +1,58 @@
+#ifndef _MULTI_QUEUE_H
+#define _MULTI_QUEUE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "heap.h"
+
+/**
+ * A relaxed priority queue for many threads at once: a multi-queue. It is
+ * made of several independent heaps, each behind its own lock, so threads
+ * rarely wait on one another the way they do on a single heap behind a
+ * single mutex. An insert goes to a random heap. A pop looks at the
+ * cached top keys of two random heaps and pops from the one with the
+ * greater key.
+ *
+ * The price is that a pop returns a large key, but not always the largest
+ * one: with c heaps per thread, it is on average within a few times c of
+ * the top (its "rank error"). Work queues and schedulers can usually live
+ * with that in exchange for scaling.
+ *
+ * Elements of elem_size bytes go in with a uint64_t key; greater keys come
+ * out first.
+ */
+typedef struct multi_queue multi_queue_t;
+
+/* Heaps per thread when multi_queue_init picks the number itself. */
+#define MULTI_QUEUE_DEFAULT_FACTOR 2
+
+/**
+ * Initializes a multi-queue of num_queues heaps. Around two to four per
+ * thread that uses it keeps both contention and rank error low. Passing 0
+ * uses MULTI_QUEUE_DEFAULT_FACTOR per online CPU.
+ */
+multi_queue_t *multi_queue_init(size_t elem_size, size_t num_queues);
+
+/**
+ * Disposes of the multi-queue, calling free_fn (unless it's NULL) on each
+ * of the elements still in it. No other thread may be using it.
+ */
+void multi_queue_free(multi_queue_t *mq, heap_free_fn free_fn);
+
+void multi_queue_insert(multi_queue_t *mq, uint64_t key, const void *elem);
+
+/**
+ * Pops an element with a large key, copying it into elem and its key into
+ * *key (unless key is NULL). Returns false if the multi-queue was empty.
+ */
+bool multi_queue_pop(multi_queue_t *mq, uint64_t *key, void *elem);
+
+/**
+ * Returns the number of elements, which may be stale by the time it
+ * returns if other threads are inserting or popping.
+ */
+size_t multi_queue_size(const multi_queue_t *mq);
+
+#endif /* _MULTI_QUEUE_H */
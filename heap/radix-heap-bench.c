@@ -0,0 +1,143 @@
+/*
+ * radix-heap-bench.c
+ * ------------------
+ * Author: Nate Hardison
+ *
+ * Times a timer queue held in a radix heap against the same queue in
+ * comparison heaps. Each queue is filled with num_elems timers, runs
+ * num_elems "hold" operations (pop the earliest, reinsert it a random
+ * delay later), then drains. Deadlines only move forward, which is all a
+ * radix heap asks of its keys.
+ * Usage: radix-heap-bench [num_elems]
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "heap.h"
+#include "radix-heap.h"
+
+#define DEFAULT_NUM_ELEMS 10000000
+#define MAX_DELAY (1 << 20)
+
+typedef struct
+{
+    uint64_t deadline;
+    uint64_t id;
+} timer_entry;
+
+/* Earliest deadline first. */
+static int cmp_deadline(const void *a, const void *b)
+{
+    uint64_t x = ((const timer_entry *)a)->deadline;
+    uint64_t y = ((const timer_entry *)b)->deadline;
+    return (x < y) - (x > y);
+}
+
+static double now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static uint64_t next_random(uint64_t *state)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+static void report(const char *name, double insert, double hold,
+                   double drain, size_t num_elems, uint64_t checksum)
+{
+    printf("%-10s %10.1f %10.1f %10.1f   (checksum %llx)\n", name,
+           insert * 1e9 / num_elems, hold * 1e9 / num_elems,
+           drain * 1e9 / num_elems, (unsigned long long)checksum);
+}
+
+static void bench_heap(const char *name, size_t arity, size_t num_elems)
+{
+    heap_t *heap = heap_init_dary(sizeof(timer_entry), cmp_deadline, arity);
+    uint64_t state = 88172645463325252ull, checksum = 0;
+
+    double start = now();
+    for (size_t i = 0; i < num_elems; i++)
+    {
+        timer_entry e = { next_random(&state) % MAX_DELAY, i };
+        heap_insert(heap, &e);
+    }
+    double insert = now() - start;
+
+    start = now();
+    for (size_t i = 0; i < num_elems; i++)
+    {
+        timer_entry *e = heap_pop_max(heap);
+        e->deadline += 1 + next_random(&state) % MAX_DELAY;
+        heap_insert(heap, e);
+    }
+    double hold = now() - start;
+
+    start = now();
+    for (size_t i = 0; i < num_elems; i++)
+    {
+        timer_entry *e = heap_pop_max(heap);
+        checksum = checksum * 31 + e->deadline;
+    }
+    double drain = now() - start;
+    heap_free(heap, NULL);
+
+    report(name, insert, hold, drain, num_elems, checksum);
+}
+
+static void bench_radix_heap(size_t num_elems)
+{
+    radix_heap_t *heap = radix_heap_init(sizeof(uint64_t));
+    uint64_t state = 88172645463325252ull, checksum = 0;
+
+    double start = now();
+    for (uint64_t i = 0; i < num_elems; i++)
+    {
+        radix_heap_insert(heap, next_random(&state) % MAX_DELAY, &i);
+    }
+    double insert = now() - start;
+
+    start = now();
+    for (size_t i = 0; i < num_elems; i++)
+    {
+        uint64_t deadline;
+        uint64_t *id = radix_heap_pop_min(heap, &deadline);
+        radix_heap_insert(heap,
+                          deadline + 1 + next_random(&state) % MAX_DELAY, id);
+    }
+    double hold = now() - start;
+
+    start = now();
+    for (size_t i = 0; i < num_elems; i++)
+    {
+        uint64_t deadline;
+        radix_heap_pop_min(heap, &deadline);
+        checksum = checksum * 31 + deadline;
+    }
+    double drain = now() - start;
+    radix_heap_free(heap, NULL);
+
+    report("radix", insert, hold, drain, num_elems, checksum);
+}
+
+int main(int argc, const char *argv[])
+{
+    size_t num_elems = (argc > 1)? strtoul(argv[1], NULL, 10)
+                                 : DEFAULT_NUM_ELEMS;
+
+    printf("%zu timers, ns per operation; checksums should match\n\n",
+           num_elems);
+    printf("%-10s %10s %10s %10s\n", "queue", "insert", "hold", "pop");
+    bench_heap("binary", 2, num_elems);
+    bench_heap("4-ary", 4, num_elems);
+    bench_radix_heap(num_elems);
+    return 0;
+}
@@ -0,0 +1,114 @@
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "radix-heap.h"
+
+static uint64_t next_random(uint64_t *state)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+static void test_radix_heap_insert()
+{
+    printf("Testing radix_heap_insert()\n---------------------------\n");
+
+    printf("Checking keys inserted up front...");
+    radix_heap_t *heap = radix_heap_init(sizeof(uint64_t));
+    uint64_t state = 42;
+    size_t n = 10000;
+    for (size_t i = 0; i < n; i++)
+    {
+        uint64_t key = next_random(&state) >> (i % 64);
+        radix_heap_insert(heap, key, &key);
+    }
+    uint64_t last = 0;
+    for (size_t i = 0; i < n; i++)
+    {
+        uint64_t min = radix_heap_min_key(heap);
+        uint64_t key;
+        uint64_t elem = *(uint64_t *)radix_heap_pop_min(heap, &key);
+        assert(key == min && elem == key);
+        assert(key >= last);
+        last = key;
+        assert(radix_heap_size(heap) == n - i - 1);
+    }
+    printf("OK!\n");
+
+    printf("Checking a timer queue, with reinserts of popped elements...");
+    for (size_t i = 0; i < n; i++)
+    {
+        uint64_t key = last + next_random(&state) % 1000;
+        radix_heap_insert(heap, key, &key);
+    }
+    for (size_t i = 0; i < 10 * n; i++)
+    {
+        uint64_t key;
+        uint64_t *elem = radix_heap_pop_min(heap, &key);
+        assert(*elem == key && key >= last);
+        last = key;
+        *elem = key + next_random(&state) % ((i % 3 == 0)? 1 : 100000);
+        radix_heap_insert(heap, *elem, elem);
+    }
+    printf("OK!\n");
+
+    printf("Checking keys equal to the last popped...");
+    while (radix_heap_size(heap) > 0)
+    {
+        radix_heap_pop_min(heap, &last);
+    }
+    for (int i = 0; i < 100; i++)
+    {
+        radix_heap_insert(heap, last, &last);
+    }
+    assert(radix_heap_size(heap) == 100);
+    while (radix_heap_size(heap) > 0)
+    {
+        uint64_t key;
+        assert(*(uint64_t *)radix_heap_pop_min(heap, &key) == last);
+        assert(key == last);
+    }
+    radix_heap_free(heap, NULL);
+    printf("OK!\n");
+
+    printf("All good with radix_heap_insert()!\n\n");
+}
+
+static void free_string(void *elem)
+{
+    free(*(char **)elem);
+}
+
+static void test_radix_heap_free()
+{
+    printf("Testing radix_heap_free()\n-------------------------\n");
+
+    printf("Checking that free_fn sees what's left...");
+    radix_heap_t *heap = radix_heap_init(sizeof(char *));
+    for (uint64_t key = 0; key < 100; key++)
+    {
+        char *name = malloc(16);
+        snprintf(name, 16, "timer %d", (int)key);
+        radix_heap_insert(heap, 1000 - key * 10, &name);
+    }
+    uint64_t key;
+    char *name = *(char **)radix_heap_pop_min(heap, &key);
+    assert(key == 10 && strcmp(name, "timer 99") == 0);
+    free(name);
+    radix_heap_free(heap, free_string);
+    printf("OK!\n");
+
+    printf("All good with radix_heap_free()!\n\n");
+}
+
+int main(int argc, const char *argv[])
+{
+    test_radix_heap_insert();
+    test_radix_heap_free();
+    return 0;
+}
@@ -0,0 +1,184 @@
+#include "radix-heap.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DEFAULT_ALLOCATION 16
+
+/* Bucket 0 holds keys equal to last; bucket b > 0 holds keys whose
+ * highest bit differing from last is bit b - 1. */
+#define NUM_BUCKETS 65
+
+/* Each entry is its key followed by the element, padded to keep the next
+ * key aligned. */
+#define ENTRY_ALIGN sizeof(uint64_t)
+#define ROUND_UP(x, a) (((x) + (a) - 1) / (a) * (a))
+
+struct bucket
+{
+    char *entries;
+    size_t num_entries;
+    size_t alloc_size; /* in entries */
+};
+
+struct radix_heap
+{
+    size_t elem_size;
+    size_t entry_size;
+    size_t num_elems;
+    uint64_t last; /* the key last popped; no key in the heap is less */
+    uint64_t nonempty; /* bit b - 1 is set if bucket b > 0 has entries */
+    struct bucket buckets[NUM_BUCKETS];
+};
+
+static inline char *ith_entry(const radix_heap_t *heap,
+                              const struct bucket *b, size_t i)
+{
+    return b->entries + (i * heap->entry_size);
+}
+
+static inline uint64_t key_of(const char *entry)
+{
+    uint64_t key;
+    memcpy(&key, entry, sizeof(key));
+    return key;
+}
+
+static inline size_t bucket_of(const radix_heap_t *heap, uint64_t key)
+{
+    return (key == heap->last)? 0 : 64 - __builtin_clzll(key ^ heap->last);
+}
+
+/**
+ * Returns a pointer to a new entry at the end of bucket b, doubling the
+ * bucket's space if it's full.
+ */
+static char *append_entry(radix_heap_t *heap, size_t b)
+{
+    struct bucket *bucket = &heap->buckets[b];
+    if (bucket->num_entries == bucket->alloc_size)
+    {
+        size_t alloc_size = (bucket->alloc_size == 0)? DEFAULT_ALLOCATION
+                                                     : 2 * bucket->alloc_size;
+        if (alloc_size > SIZE_MAX / heap->entry_size)
+        {
+            fprintf(stderr, "error: append_entry(): Heap too large\n");
+            exit(1);
+        }
+        char *entries = realloc(bucket->entries,
+                                alloc_size * heap->entry_size);
+        if (entries == NULL)
+        {
+            fprintf(stderr, "error: append_entry(): Out of heap memory\n");
+            exit(1);
+        }
+        bucket->entries = entries;
+        bucket->alloc_size = alloc_size;
+    }
+    if (b > 0) heap->nonempty |= (uint64_t)1 << (b - 1);
+    return ith_entry(heap, bucket, bucket->num_entries++);
+}
+
+/**
+ * Refills bucket 0 when it's empty: the least key in the lowest non-empty
+ * bucket becomes last, and every entry in that bucket moves to a lower
+ * one, now that they differ from last in a lower bit.
+ */
+static void redistribute(radix_heap_t *heap)
+{
+    assert(heap->nonempty != 0);
+    size_t b = __builtin_ctzll(heap->nonempty) + 1;
+    struct bucket *bucket = &heap->buckets[b];
+
+    uint64_t min = key_of(bucket->entries);
+    for (size_t i = 1; i < bucket->num_entries; i++)
+    {
+        uint64_t key = key_of(ith_entry(heap, bucket, i));
+        if (key < min) min = key;
+    }
+    heap->last = min;
+
+    for (size_t i = 0; i < bucket->num_entries; i++)
+    {
+        char *entry = ith_entry(heap, bucket, i);
+        memcpy(append_entry(heap, bucket_of(heap, key_of(entry))), entry,
+               heap->entry_size);
+    }
+    bucket->num_entries = 0;
+    heap->nonempty &= ~((uint64_t)1 << (b - 1));
+}
+
+radix_heap_t *radix_heap_init(size_t elem_size)
+{
+    radix_heap_t *heap = calloc(1, sizeof(radix_heap_t));
+    if (heap == NULL)
+    {
+        fprintf(stderr, "error: radix_heap_init(): Out of heap memory\n");
+        exit(1);
+    }
+    heap->elem_size = elem_size;
+    heap->entry_size = ROUND_UP(sizeof(uint64_t) + elem_size, ENTRY_ALIGN);
+    return heap;
+}
+
+void radix_heap_free(radix_heap_t *heap, heap_free_fn free_fn)
+{
+    assert(heap != NULL);
+    for (size_t b = 0; b < NUM_BUCKETS; b++)
+    {
+        struct bucket *bucket = &heap->buckets[b];
+        if (free_fn != NULL)
+        {
+            for (size_t i = 0; i < bucket->num_entries; i++)
+            {
+                free_fn(ith_entry(heap, bucket, i) + sizeof(uint64_t));
+            }
+        }
+        free(bucket->entries);
+    }
+    free(heap);
+}
+
+void radix_heap_insert(radix_heap_t *heap, uint64_t key, const void *elem)
+{
+    assert(heap != NULL);
+    assert(elem != NULL);
+    assert(key >= heap->last);
+    /* elem may be the element just popped, in the slot past the end of
+     * bucket 0. That bucket has room, so appending can't move it, but it
+     * may be the very slot appended to. */
+    char *entry = append_entry(heap, bucket_of(heap, key));
+    memcpy(entry, &key, sizeof(key));
+    memmove(entry + sizeof(uint64_t), elem, heap->elem_size);
+    heap->num_elems++;
+}
+
+void *radix_heap_pop_min(radix_heap_t *heap, uint64_t *key)
+{
+    assert(heap != NULL);
+    assert(heap->num_elems > 0);
+    struct bucket *bucket = &heap->buckets[0];
+    if (bucket->num_entries == 0) redistribute(heap);
+    heap->num_elems--;
+    /* Every key in bucket 0 is last, so any entry will do: take the one
+     * at the end, which stays put, just past the bucket's end. */
+    char *entry = ith_entry(heap, bucket, --bucket->num_entries);
+    if (key != NULL) *key = heap->last;
+    return entry + sizeof(uint64_t);
+}
+
+uint64_t radix_heap_min_key(radix_heap_t *heap)
+{
+    assert(heap != NULL);
+    assert(heap->num_elems > 0);
+    if (heap->buckets[0].num_entries == 0) redistribute(heap);
+    return heap->last;
+}
+
+size_t radix_heap_size(const radix_heap_t *heap)
+{
+    assert(heap != NULL);
+    return heap->num_elems;
+}
@@ -0,0 +1,53 @@
+#ifndef _RADIX_HEAP_H
+#define _RADIX_HEAP_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "heap.h"
+
+/**
+ * A min-priority queue for unsigned integer keys that never go below the
+ * last key popped, as with timer deadlines or Dijkstra's distances. Each
+ * element of elem_size bytes rides along with its key.
+ *
+ * Rather than compare elements, a radix heap files each one in a bucket
+ * by the highest bit in which its key differs from the last key popped.
+ * Inserting is O(1). Popping, once the bucket of equal keys runs dry,
+ * empties the lowest non-empty bucket into the buckets below it, and a
+ * key can only move down 64 times, so pops are O(log C) amortized for
+ * keys up to C.
+ */
+typedef struct radix_heap radix_heap_t;
+
+radix_heap_t *radix_heap_init(size_t elem_size);
+
+/**
+ * Disposes of the heap, calling free_fn (unless it's NULL) on each of the
+ * elements still in it.
+ */
+void radix_heap_free(radix_heap_t *heap, heap_free_fn free_fn);
+
+/**
+ * Adds a copy of elem with the given key, which must be no less than the
+ * key last popped.
+ */
+void radix_heap_insert(radix_heap_t *heap, uint64_t key, const void *elem);
+
+/**
+ * Removes an element with the least key and returns a pointer to it,
+ * storing its key in *key unless key is NULL. The element becomes the
+ * caller's; the pointer stays good until the heap next changes, and may be
+ * passed straight back to radix_heap_insert. The heap must not be empty.
+ */
+void *radix_heap_pop_min(radix_heap_t *heap, uint64_t *key);
+
+/**
+ * Returns the least key in the heap, which must not be empty. This may
+ * move elements between buckets, so it counts as a change to the heap.
+ */
+uint64_t radix_heap_min_key(radix_heap_t *heap);
+
+size_t radix_heap_size(const radix_heap_t *heap);
+
+#endif /* _RADIX_HEAP_H */
@@ -0,0 +1,216 @@
+/*
+ * lfstack-test.c
+ * -----
+ * Author: Nate Hardison
+ *
+ * Tests for the lock-free stack, then a throughput comparison against
+ * push and pop from the node module behind a mutex. Every worker thread
+ * pops a node_t off a shared stack and pushes it straight back, as fast
+ * as it can; afterward every node must be on the stack exactly once.
+ * Usage: lfstack-test [num_threads] [ops_per_thread]
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "lfstack.h"
+#include "node.h"
+
+#define DEFAULT_NUM_THREADS 32
+#define DEFAULT_OPS_PER_THREAD 200000
+#define NUM_NODES 64
+
+static size_t ops_per_thread = DEFAULT_OPS_PER_THREAD;
+
+static node_t *
+new_int_node(int i)
+{
+    node_t *n = malloc(sizeof(node_t) + sizeof(int));
+    assert(n != NULL);
+    n->next = NULL;
+    memcpy(n->data, &i, sizeof(int));
+    return n;
+}
+
+static int
+int_of(node_t *n)
+{
+    return *(int *)n->data;
+}
+
+static double
+now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* Pops everything off the chain headed at head, checking that each of
+ * nodes[0..NUM_NODES) turns up exactly once, and frees them. */
+static void
+verify_and_free(node_t *head, node_t *nodes[])
+{
+    bool seen[NUM_NODES] = { false };
+    size_t count = 0;
+    for (node_t *n = head; n != NULL; n = n->next)
+    {
+        int i = int_of(n);
+        assert(i >= 0 && i < NUM_NODES);
+        assert(nodes[i] == n);
+        assert(!seen[i]);
+        seen[i] = true;
+        count++;
+    }
+    assert(count == NUM_NODES);
+    for (int i = 0; i < NUM_NODES; i++)
+    {
+        free(nodes[i]);
+    }
+}
+
+static void
+test_push_pop()
+{
+    printf("Testing lfstack_push() and lfstack_pop()\n"
+           "----------------------------------------\n");
+
+    lfstack_t *stack = lfstack_init();
+    assert(lfstack_empty(stack));
+    assert(lfstack_pop(stack) == NULL);
+
+    node_t *nodes[3];
+    for (int i = 0; i < 3; i++)
+    {
+        nodes[i] = new_int_node(i);
+        lfstack_push(stack, nodes[i]);
+    }
+    assert(!lfstack_empty(stack));
+    for (int i = 2; i >= 0; i--)
+    {
+        node_t *n = lfstack_pop(stack);
+        assert(n == nodes[i] && int_of(n) == i);
+        free(n);
+    }
+    assert(lfstack_empty(stack));
+    assert(lfstack_pop(stack) == NULL);
+    lfstack_free(stack);
+
+    printf("All good with lfstack_push() and lfstack_pop()!\n\n");
+}
+
+static void *
+lfstack_worker(void *aux_data)
+{
+    lfstack_t *stack = aux_data;
+    for (size_t i = 0; i < ops_per_thread; i++)
+    {
+        node_t *n = lfstack_pop(stack);
+        if (n != NULL) lfstack_push(stack, n);
+    }
+    return NULL;
+}
+
+struct locked_stack
+{
+    pthread_mutex_t lock;
+    node_t *head;
+};
+
+static void *
+locked_worker(void *aux_data)
+{
+    struct locked_stack *stack = aux_data;
+    for (size_t i = 0; i < ops_per_thread; i++)
+    {
+        pthread_mutex_lock(&stack->lock);
+        node_t *n = (stack->head != NULL)? pop(&stack->head) : NULL;
+        pthread_mutex_unlock(&stack->lock);
+        if (n == NULL) continue;
+        pthread_mutex_lock(&stack->lock);
+        push(&stack->head, n);
+        pthread_mutex_unlock(&stack->lock);
+    }
+    return NULL;
+}
+
+/* Runs worker on num_threads threads at once; returns the seconds taken. */
+static double
+run_threads(void *(*worker)(void *), void *stack, size_t num_threads)
+{
+    pthread_t *threads = malloc(num_threads * sizeof(pthread_t));
+    assert(threads != NULL);
+    double start = now();
+    for (size_t i = 0; i < num_threads; i++)
+    {
+        int err = pthread_create(&threads[i], NULL, worker, stack);
+        assert(err == 0);
+    }
+    for (size_t i = 0; i < num_threads; i++)
+    {
+        pthread_join(threads[i], NULL);
+    }
+    double elapsed = now() - start;
+    free(threads);
+    return elapsed;
+}
+
+static void
+test_contention(size_t num_threads)
+{
+    printf("Testing %zu threads x %zu pop/push pairs\n"
+           "----------------------------------------\n",
+           num_threads, ops_per_thread);
+
+    node_t *nodes[NUM_NODES];
+    double ops = 2.0 * num_threads * ops_per_thread;
+
+    lfstack_t *stack = lfstack_init();
+    for (int i = 0; i < NUM_NODES; i++)
+    {
+        nodes[i] = new_int_node(i);
+        lfstack_push(stack, nodes[i]);
+    }
+    double lock_free = run_threads(lfstack_worker, stack, num_threads);
+    node_t *head = NULL;
+    for (node_t *n; (n = lfstack_pop(stack)) != NULL; )
+    {
+        push(&head, n);
+    }
+    verify_and_free(head, nodes);
+    printf("lfstack:  %6.1f Mops/s%s\n", ops / lock_free / 1e6,
+           lfstack_is_lock_free(stack)? "" : " (CAS emulated with a lock)");
+    lfstack_free(stack);
+
+    struct locked_stack locked = { PTHREAD_MUTEX_INITIALIZER, NULL };
+    for (int i = 0; i < NUM_NODES; i++)
+    {
+        nodes[i] = new_int_node(i);
+        push(&locked.head, nodes[i]);
+    }
+    double mutex = run_threads(locked_worker, &locked, num_threads);
+    verify_and_free(locked.head, nodes);
+    printf("mutex:    %6.1f Mops/s\n", ops / mutex / 1e6);
+    printf("speedup:  %6.2fx\n", mutex / lock_free);
+
+    printf("All good with %zu threads!\n\n", num_threads);
+}
+
+int
+main(int argc, const char *argv[])
+{
+    size_t num_threads = (argc > 1)? strtoul(argv[1], NULL, 10)
+                                   : DEFAULT_NUM_THREADS;
+    if (argc > 2) ops_per_thread = strtoul(argv[2], NULL, 10);
+
+    test_push_pop();
+    test_contention(1);
+    test_contention(num_threads);
+
+    return 0;
+}
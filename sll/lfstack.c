@@ -0,0 +1,131 @@
+#include "lfstack.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "node.h"
+
+/* The head and its pop counter, compared and swapped as one unit. */
+struct tagged
+{
+  node_t *top;
+  uintptr_t tag;
+};
+
+/* Where the compiler can inline a double-width CAS (cmpxchg16b, with
+ * -mcx16 on x86-64) the head is swapped as one integer. Otherwise the
+ * generic __atomic calls go through libatomic, which may take a lock. */
+#ifdef __GCC_HAVE_SYNC_COMPARE_AND_SWAP_16
+#define INLINE_DWCAS
+__extension__ typedef unsigned __int128 dword_t;
+#else
+typedef struct tagged dword_t;
+#endif
+
+union head
+{
+  struct tagged tagged;
+  dword_t word;
+};
+
+struct lfstack
+{
+  union head head;
+};
+
+/* Reads the head one word at a time. The two halves may be torn, but a
+ * torn read simply makes the following CAS fail. */
+static struct tagged load_head(lfstack_t *stack)
+{
+  struct tagged head;
+  head.top = __atomic_load_n(&stack->head.tagged.top, __ATOMIC_ACQUIRE);
+  head.tag = __atomic_load_n(&stack->head.tagged.tag, __ATOMIC_RELAXED);
+  return head;
+}
+
+/* Swaps in new if the head still equals *old; otherwise stores the head
+ * it found in *old. */
+static bool cas_head(lfstack_t *stack, struct tagged *old, struct tagged new)
+{
+#ifdef INLINE_DWCAS
+  union head expected = { *old }, desired = { new }, found;
+  found.word = __sync_val_compare_and_swap(&stack->head.word, expected.word,
+                                           desired.word);
+  if (found.word == expected.word) return true;
+  *old = found.tagged;
+  return false;
+#else
+  return __atomic_compare_exchange(&stack->head.tagged, old, &new, false,
+                                   __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+#endif
+}
+
+lfstack_t *lfstack_init(void)
+{
+  lfstack_t *stack = malloc(sizeof(lfstack_t));
+  if (stack == NULL)
+  {
+    fprintf(stderr, "error: lfstack_init(): Out of heap memory\n");
+    exit(1);
+  }
+  /* The double-width CAS needs the head aligned to its own size. */
+  assert((uintptr_t)&stack->head % sizeof(struct tagged) == 0);
+  stack->head.tagged.top = NULL;
+  stack->head.tagged.tag = 0;
+  return stack;
+}
+
+void lfstack_free(lfstack_t *stack)
+{
+  assert(stack != NULL);
+  free(stack);
+}
+
+void lfstack_push(lfstack_t *stack, node_t *n)
+{
+  assert(stack != NULL);
+  assert(n != NULL);
+  struct tagged old = load_head(stack), new;
+  do
+  {
+    /* A stale pop may be reading n->next right now, hence the atomic. */
+    __atomic_store_n(&n->next, old.top, __ATOMIC_RELAXED);
+    new.top = n;
+    new.tag = old.tag;
+  }
+  while (!cas_head(stack, &old, new));
+}
+
+node_t *lfstack_pop(lfstack_t *stack)
+{
+  assert(stack != NULL);
+  struct tagged old = load_head(stack), new;
+  do
+  {
+    if (old.top == NULL) return NULL;
+    /* old.top may already be gone; if so the CAS below fails. */
+    new.top = __atomic_load_n(&old.top->next, __ATOMIC_RELAXED);
+    new.tag = old.tag + 1;
+  }
+  while (!cas_head(stack, &old, new));
+  return old.top;
+}
+
+bool lfstack_empty(lfstack_t *stack)
+{
+  assert(stack != NULL);
+  return __atomic_load_n(&stack->head.tagged.top, __ATOMIC_RELAXED) == NULL;
+}
+
+bool lfstack_is_lock_free(lfstack_t *stack)
+{
+  assert(stack != NULL);
+#ifdef INLINE_DWCAS
+  return true;
+#else
+  return __atomic_is_lock_free(sizeof(struct tagged), &stack->head);
+#endif
+}
@@ -0,0 +1,45 @@
+/**
+ * lfstack.h
+ * ---------
+ * Author: Nate Hardison
+ *
+ * Implementation of a lock-free concurrent stack of node_ts (a Treiber
+ * stack). It is push and pop from the node module made thread-safe with a
+ * compare-and-swap on the head in place of a mutex. The head is paired
+ * with a counter that every successful pop bumps, and both are swapped
+ * together in one double-width CAS. So a pop that read a head which has
+ * since been popped and pushed back (the ABA problem) fails and retries
+ * rather than corrupting the stack.
+ *
+ * The stack only links nodes; it never allocates or frees them. A pop may
+ * still read the next pointer of a node that another thread has just
+ * popped, so nodes must stay mapped while any thread may be popping:
+ * recycle them (for instance through a pool_t, with its own locking) or
+ * free them only once the stack has gone quiet.
+ */
+#include <stdbool.h>
+
+#include "node.h"
+
+#ifndef SLL_LFSTACK_H_
+#define SLL_LFSTACK_H_
+
+typedef struct lfstack lfstack_t;
+
+lfstack_t *lfstack_init(void);
+
+/* Frees the stack itself, not any nodes still on it. */
+void lfstack_free(lfstack_t *stack);
+
+void lfstack_push(lfstack_t *stack, node_t *n);
+
+/* Returns the top node_t, or NULL if the stack is empty. */
+node_t *lfstack_pop(lfstack_t *stack);
+
+/* A snapshot; other threads may change it at any moment. */
+bool lfstack_empty(lfstack_t *stack);
+
+/* Whether the double-width CAS runs without a hidden lock on this CPU. */
+bool lfstack_is_lock_free(lfstack_t *stack);
+
+#endif /* SLL_LFSTACK_H_ */
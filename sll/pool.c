@@ -0,0 +1,156 @@
+#include "pool.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/* Every slot (and the start of every chunk's slot area) is rounded up to
+ * the size of this so whatever lives in a slot is as aligned as malloc
+ * would make it. */
+union max_align
+{
+  long long ll;
+  long double ld;
+  void *ptr;
+  void (*fn)(void);
+};
+#define SLOT_ALIGN sizeof(union max_align)
+#define ROUND_UP(x, a) (((x) + (a) - 1) / (a) * (a))
+
+struct chunk
+{
+  struct chunk *next;
+};
+
+/* A recycled slot threads the free list through its own storage. */
+struct slot
+{
+  struct slot *next;
+};
+
+struct pool
+{
+  size_t slot_size;
+  size_t slots_per_chunk;
+  size_t refs;
+  struct chunk *chunks;
+  struct slot *free_list;
+  size_t num_free;  /* free-list slots plus unused slots in the chunk */
+  char *bump;       /* next never-used slot in the newest chunk */
+  size_t bump_left;
+};
+
+static const size_t chunk_header = ROUND_UP(sizeof(struct chunk), SLOT_ALIGN);
+
+static void add_chunk(pool_t *pool, size_t num_slots)
+{
+  struct chunk *c = malloc(chunk_header + num_slots * pool->slot_size);
+  if (c == NULL)
+  {
+    fprintf(stderr, "error: add_chunk(): Out of heap memory\n");
+    exit(1);
+  }
+  c->next = pool->chunks;
+  pool->chunks = c;
+  /* Whatever was left of the previous chunk goes on the free list so it
+   * isn't lost when the bump pointer moves on. */
+  for (; pool->bump_left > 0; pool->bump_left--)
+  {
+    struct slot *s = (struct slot *)pool->bump;
+    s->next = pool->free_list;
+    pool->free_list = s;
+    pool->bump += pool->slot_size;
+  }
+  pool->bump = (char *)c + chunk_header;
+  pool->bump_left = num_slots;
+  pool->num_free += num_slots;
+}
+
+pool_t *pool_init(size_t slot_size, size_t slots_per_chunk)
+{
+  assert(slot_size > 0);
+  assert(slots_per_chunk > 0);
+  pool_t *pool = calloc(1, sizeof(pool_t));
+  if (pool == NULL)
+  {
+    fprintf(stderr, "error: pool_init(): Out of heap memory\n");
+    exit(1);
+  }
+  if (slot_size < sizeof(struct slot)) slot_size = sizeof(struct slot);
+  pool->slot_size = ROUND_UP(slot_size, SLOT_ALIGN);
+  pool->slots_per_chunk = slots_per_chunk;
+  pool->refs = 1;
+  return pool;
+}
+
+void pool_retain(pool_t *pool)
+{
+  assert(pool != NULL);
+  pool->refs++;
+}
+
+void pool_release(pool_t *pool)
+{
+  assert(pool != NULL);
+  assert(pool->refs > 0);
+  if (--pool->refs > 0) return;
+  while (pool->chunks != NULL)
+  {
+    struct chunk *c = pool->chunks;
+    pool->chunks = c->next;
+    free(c);
+  }
+  free(pool);
+}
+
+size_t pool_refs(const pool_t *pool)
+{
+  assert(pool != NULL);
+  return pool->refs;
+}
+
+size_t pool_slot_size(const pool_t *pool)
+{
+  assert(pool != NULL);
+  return pool->slot_size;
+}
+
+void *pool_alloc(pool_t *pool)
+{
+  assert(pool != NULL);
+  if (pool->free_list != NULL)
+  {
+    struct slot *s = pool->free_list;
+    pool->free_list = s->next;
+    pool->num_free--;
+    return s;
+  }
+  if (pool->bump_left == 0)
+  {
+    add_chunk(pool, pool->slots_per_chunk);
+  }
+  void *slot = pool->bump;
+  pool->bump += pool->slot_size;
+  pool->bump_left--;
+  pool->num_free--;
+  return slot;
+}
+
+void pool_recycle(pool_t *pool, void *slot)
+{
+  assert(pool != NULL);
+  assert(slot != NULL);
+  struct slot *s = slot;
+  s->next = pool->free_list;
+  pool->free_list = s;
+  pool->num_free++;
+}
+
+void pool_reserve(pool_t *pool, size_t n)
+{
+  assert(pool != NULL);
+  if (pool->num_free >= n) return;
+  size_t missing = n - pool->num_free;
+  add_chunk(pool, (missing > pool->slots_per_chunk)?
+            missing : pool->slots_per_chunk);
+}
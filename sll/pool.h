@@ -0,0 +1,35 @@
+/**
+ * pool.h
+ * ------
+ * Author: Nate Hardison
+ *
+ * Implementation of a fixed-size slab allocator. A pool carves slots of
+ * one size out of large chunks and recycles released slots through a
+ * free list, so steady-state allocation never reaches malloc and freeing
+ * the pool costs one free per chunk, not per slot. The sll module uses
+ * pools to allocate its node_ts; a pool may be shared between several
+ * lists with the same node size and lives until its last user releases
+ * it.
+ */
+#include <stdlib.h>
+
+#ifndef SLL_POOL_H_
+#define SLL_POOL_H_
+
+typedef struct pool pool_t;
+
+pool_t *pool_init(size_t slot_size, size_t slots_per_chunk);
+void pool_retain(pool_t *pool);
+
+/* Drops a reference, freeing every chunk once the last one is gone. */
+void pool_release(pool_t *pool);
+size_t pool_refs(const pool_t *pool);
+size_t pool_slot_size(const pool_t *pool);
+
+void *pool_alloc(pool_t *pool);
+void pool_recycle(pool_t *pool, void *slot);
+
+/* Makes sure the next n calls to pool_alloc won't allocate a chunk. */
+void pool_reserve(pool_t *pool, size_t n);
+
+#endif /* SLL_POOL_H_ */
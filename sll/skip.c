@@ -0,0 +1,239 @@
+#include "skip.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/* 4^16 nodes is well past anything that fits in memory. */
+#define MAX_LEVEL 16
+
+struct tower
+{
+  node_t *node;
+  size_t height;
+  struct tower *next[];  /* next[k] is the next tower at level k + 1 */
+};
+
+struct skip
+{
+  skip_cmp_fn cmp_fn;
+  size_t levels;  /* highest level any tower reaches */
+  struct tower *first[MAX_LEVEL];
+  unsigned long seed;
+};
+
+/* Each level up is reached with probability 1/4, two bits of an
+ * xorshift draw apiece. */
+static size_t random_height(skip_t *index)
+{
+  unsigned long x = index->seed;
+  x ^= x << 13;
+  x ^= x >> 7;
+  x ^= x << 17;
+  index->seed = x;
+  size_t height = 0;
+  while (height < MAX_LEVEL && (x & 3) == 0)
+  {
+    height++;
+    x >>= 2;
+  }
+  return height;
+}
+
+static struct tower *build_tower(node_t *n, size_t height)
+{
+  struct tower *t = malloc(sizeof(struct tower) +
+                           height * sizeof(struct tower *));
+  if (t == NULL)
+  {
+    fprintf(stderr, "error: build_tower(): Out of heap memory\n");
+    exit(1);
+  }
+  t->node = n;
+  t->height = height;
+  return t;
+}
+
+/* The tower after pred at the given level, where a NULL pred stands for
+ * the front of the list. */
+static struct tower *next_at(const skip_t *index, struct tower *pred,
+                             size_t level)
+{
+  return (pred == NULL)? index->first[level - 1] : pred->next[level - 1];
+}
+
+static bool goes_before(const skip_t *index, node_t *n, const void *key,
+                        bool after_equal)
+{
+  int cmp = index->cmp_fn(n->data, key);
+  return after_equal? cmp <= 0 : cmp < 0;
+}
+
+/* Fills preds[k] with the last tower at level k + 1 that goes before key,
+ * and returns the node the level-0 walk should start from. */
+static node_t *find_preds(const skip_t *index, const void *key,
+                          bool after_equal, struct tower **preds)
+{
+  struct tower *pred = NULL;
+  for (size_t level = index->levels; level > 0; level--)
+  {
+    for (struct tower *t = next_at(index, pred, level);
+         t != NULL && goes_before(index, t->node, key, after_equal);
+         t = t->next[level - 1])
+    {
+      pred = t;
+    }
+    preds[level - 1] = pred;
+  }
+  return (pred == NULL)? NULL : pred->node;
+}
+
+skip_t *skip_init(skip_cmp_fn cmp_fn)
+{
+  assert(cmp_fn != NULL);
+  skip_t *index = calloc(1, sizeof(skip_t));
+  if (index == NULL)
+  {
+    fprintf(stderr, "error: skip_init(): Out of heap memory\n");
+    exit(1);
+  }
+  index->cmp_fn = cmp_fn;
+  index->seed = 2463534242UL;
+  return index;
+}
+
+static void clear(skip_t *index)
+{
+  /* Every tower is at least one level tall, so level 1 has them all. */
+  struct tower *t = index->first[0];
+  while (t != NULL)
+  {
+    struct tower *next = t->next[0];
+    free(t);
+    t = next;
+  }
+  for (size_t level = 0; level < MAX_LEVEL; level++)
+  {
+    index->first[level] = NULL;
+  }
+  index->levels = 0;
+}
+
+void skip_free(skip_t *index)
+{
+  assert(index != NULL);
+  clear(index);
+  free(index);
+}
+
+skip_cmp_fn skip_cmp(const skip_t *index)
+{
+  assert(index != NULL);
+  return index->cmp_fn;
+}
+
+void skip_build(skip_t *index, node_t *head)
+{
+  assert(index != NULL);
+  clear(index);
+  struct tower **last[MAX_LEVEL];
+  for (size_t level = 0; level < MAX_LEVEL; level++)
+  {
+    last[level] = &index->first[level];
+  }
+  for (node_t *n = head; n != NULL; n = n->next)
+  {
+    size_t height = random_height(index);
+    if (height == 0) continue;
+    struct tower *t = build_tower(n, height);
+    for (size_t level = 0; level < height; level++)
+    {
+      t->next[level] = NULL;
+      *last[level] = t;
+      last[level] = &t->next[level];
+    }
+    if (height > index->levels) index->levels = height;
+  }
+}
+
+node_t *skip_find_pred(const skip_t *index, node_t *head, const void *key,
+                       bool after_equal)
+{
+  assert(index != NULL);
+  struct tower *preds[MAX_LEVEL];
+  node_t *pred = find_preds(index, key, after_equal, preds);
+  node_t *n = (pred == NULL)? head : pred->next;
+  for (; n != NULL && goes_before(index, n, key, after_equal); n = n->next)
+  {
+    pred = n;
+  }
+  return pred;
+}
+
+node_t *skip_insert(skip_t *index, node_t *head, node_t *n)
+{
+  assert(index != NULL);
+  assert(n != NULL);
+  struct tower *preds[MAX_LEVEL];
+  node_t *pred = find_preds(index, n->data, true, preds);
+  for (node_t *cur = (pred == NULL)? head : pred->next;
+       cur != NULL && goes_before(index, cur, n->data, true);
+       cur = cur->next)
+  {
+    pred = cur;
+  }
+  size_t height = random_height(index);
+  if (height == 0) return pred;
+  struct tower *t = build_tower(n, height);
+  for (size_t level = 1; level <= height; level++)
+  {
+    struct tower *p = (level <= index->levels)? preds[level - 1] : NULL;
+    t->next[level - 1] = next_at(index, p, level);
+    if (p == NULL)
+    {
+      index->first[level - 1] = t;
+    }
+    else
+    {
+      p->next[level - 1] = t;
+    }
+  }
+  if (height > index->levels) index->levels = height;
+  return pred;
+}
+
+void skip_remove(skip_t *index, node_t *n)
+{
+  assert(index != NULL);
+  assert(n != NULL);
+  struct tower *preds[MAX_LEVEL];
+  find_preds(index, n->data, false, preds);
+  struct tower *t = NULL;
+  for (size_t level = index->levels; level > 0; level--)
+  {
+    /* Skip past towers of equal elements to the one standing on n. */
+    struct tower *p = preds[level - 1];
+    struct tower *cur = next_at(index, p, level);
+    while (cur != NULL && cur->node != n &&
+           index->cmp_fn(cur->node->data, n->data) == 0)
+    {
+      p = cur;
+      cur = cur->next[level - 1];
+    }
+    if (cur == NULL || cur->node != n) continue;
+    t = cur;
+    if (p == NULL)
+    {
+      index->first[level - 1] = t->next[level - 1];
+    }
+    else
+    {
+      p->next[level - 1] = t->next[level - 1];
+    }
+  }
+  free(t);
+  while (index->levels > 0 && index->first[index->levels - 1] == NULL)
+  {
+    index->levels--;
+  }
+}
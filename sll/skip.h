@@ -0,0 +1,44 @@
+/**
+ * skip.h
+ * ------
+ * Author: Nate Hardison
+ *
+ * Implementation of a skip-list index over a sorted chain of node_ts. The
+ * chain itself is level 0; the index only adds towers of express links
+ * above a random quarter of the nodes (a quarter of those reach level 2,
+ * and so on), so searches and sorted inserts take expected O(log n) steps
+ * while plain traversal of the chain is unaffected. The index never links
+ * or unlinks node_ts itself: callers do that and keep it informed.
+ */
+#include <stdbool.h>
+
+#include "node.h"
+
+#ifndef SLL_SKIP_H_
+#define SLL_SKIP_H_
+
+typedef int (*skip_cmp_fn)(const void *a, const void *b);
+
+typedef struct skip skip_t;
+
+skip_t *skip_init(skip_cmp_fn cmp_fn);
+void skip_free(skip_t *index);
+skip_cmp_fn skip_cmp(const skip_t *index);
+
+/* Throws away all towers and builds new ones over the sorted chain. */
+void skip_build(skip_t *index, node_t *head);
+
+/* Returns the last node in the chain whose data compares less than key
+ * (or no greater than key, if after_equal), or NULL if there isn't one. */
+node_t *skip_find_pred(const skip_t *index, node_t *head, const void *key,
+                       bool after_equal);
+
+/* Gives n a tower, if it draws one, and returns the node it should be
+ * linked in after to keep the chain sorted (after any equal elements),
+ * or NULL for the front. */
+node_t *skip_insert(skip_t *index, node_t *head, node_t *n);
+
+/* Forgets n's tower, if it has one. Call before unlinking n. */
+void skip_remove(skip_t *index, node_t *n);
+
+#endif /* SLL_SKIP_H_ */
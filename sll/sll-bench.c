@@ -0,0 +1,202 @@
+/*
+ * sll-bench.c
+ * -----
+ * Author: Nate Hardison
+ *
+ * Times full scans (sll_map) of lists too big for the last-level cache,
+ * without prefetching and with each way of prefetching, across the ways a
+ * list can be laid out in memory. The lists are built identically but for
+ * the jump pointers of a SLL_PREFETCH_JUMP list, so their cost in memory
+ * traffic is part of the comparison.
+ * It then pits the generic sll against an SLL_DEFINE list of the same ints
+ * on elem_count, which compares every element.
+ * Usage: sll-bench [num_elems] [prefetch_distance]
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "sll.h"
+#include "sll-typed.h"
+
+#define DEFAULT_NUM_ELEMS (1 << 23)
+#define DEFAULT_DISTANCE 8
+#define UNROLLED_NODE_CAPACITY 16
+#define NUM_RUNS 3
+
+#define MIN(x, y) (((x) < (y))? (x) : (y))
+
+#define cmp_int_val(a, b) (((a) > (b)) - ((a) < (b)))
+SLL_DEFINE(int_list, int, cmp_int_val)
+
+static int
+cmp_int(const void *a, const void *b)
+{
+    int x = *(const int *)a, y = *(const int *)b;
+    return cmp_int_val(x, y);
+}
+
+static void
+sum_int(void *elem, void *aux_data)
+{
+    *(long *)aux_data += *(int *)elem;
+}
+
+static double
+now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* Relinks the list's nodes in a random order, so that following next
+ * pointers jumps all over memory. */
+static void
+shuffle_links(sll *list)
+{
+    size_t len = 0;
+    for (node_t *n = list->head; n != NULL; n = n->next) len++;
+    node_t **nodes = malloc(len * sizeof(node_t *));
+    size_t i = 0;
+    for (node_t *n = list->head; n != NULL; n = n->next) nodes[i++] = n;
+    srandom(107);
+    for (i = len - 1; i > 0; i--)
+    {
+        size_t j = random() % (i + 1);
+        node_t *tmp = nodes[i];
+        nodes[i] = nodes[j];
+        nodes[j] = tmp;
+    }
+    for (i = 0; i + 1 < len; i++) nodes[i]->next = nodes[i + 1];
+    nodes[len - 1]->next = NULL;
+    list->head = nodes[0];
+    list->tail = nodes[len - 1];
+    free(nodes);
+}
+
+/* Best-of-NUM_RUNS ns per element for one full scan. */
+static double
+time_scan(sll *list)
+{
+    double best = 0;
+    for (int run = 0; run < NUM_RUNS; run++)
+    {
+        long sum = 0;
+        double start = now();
+        sll_map(list, sum_int, &sum);
+        double elapsed = now() - start;
+        if (run == 0 || elapsed < best) best = elapsed;
+        if (sum == 42) printf("(unlikely)\n");
+    }
+    return best * 1e9 / sll_length(list);
+}
+
+static sll *
+build(size_t num_elems, size_t elems_per_node, int pooled, int shuffled,
+      enum sll_prefetch prefetch, size_t distance)
+{
+    sll *list = sll_init_prefetch(sizeof(int), elems_per_node, prefetch,
+                                  (prefetch == SLL_PREFETCH_NONE)? 0 : distance,
+                                  NULL);
+    if (pooled) sll_reserve(list, num_elems);
+    for (size_t i = 0; i < num_elems; i++)
+    {
+        int elem = (int)i;
+        sll_append(list, &elem);
+    }
+    if (shuffled) shuffle_links(list);
+    sll_build_prefetch(list);
+    return list;
+}
+
+static void
+bench(const char *name, size_t num_elems, size_t elems_per_node,
+      int pooled, int shuffled, size_t distance)
+{
+    double ns[3];
+    for (int prefetch = SLL_PREFETCH_NONE; prefetch <= SLL_PREFETCH_JUMP;
+         prefetch++)
+    {
+        sll *list = build(num_elems, elems_per_node, pooled, shuffled,
+                          prefetch, distance);
+        ns[prefetch] = time_scan(list);
+        sll_free(list);
+    }
+
+    printf("%-28s %8.2f %8.2f %8.2f %9.2fx\n", name, ns[SLL_PREFETCH_NONE],
+           ns[SLL_PREFETCH_AHEAD], ns[SLL_PREFETCH_JUMP],
+           ns[SLL_PREFETCH_NONE] / MIN(ns[SLL_PREFETCH_AHEAD],
+                                       ns[SLL_PREFETCH_JUMP]));
+}
+
+/* Best-of-NUM_RUNS ns per element for sll_elem_count, generic and typed,
+ * over pool-backed lists of the same ints. */
+static void
+bench_typed(size_t num_elems)
+{
+    sll *generic = sll_init(sizeof(int), NULL);
+    int_list *typed = int_list_init();
+    sll_reserve(generic, num_elems);
+    int_list_reserve(typed, num_elems);
+    for (size_t i = 0; i < num_elems; i++)
+    {
+        int elem = (int)(i % 1000);
+        sll_append(generic, &elem);
+        int_list_append(typed, elem);
+    }
+
+    double generic_best = 0, typed_best = 0;
+    int key = 7;
+    for (int run = 0; run < NUM_RUNS; run++)
+    {
+        double start = now();
+        size_t count = sll_elem_count(generic, &key, cmp_int);
+        double elapsed = now() - start;
+        if (run == 0 || elapsed < generic_best) generic_best = elapsed;
+
+        start = now();
+        count -= int_list_elem_count(typed, key);
+        elapsed = now() - start;
+        if (run == 0 || elapsed < typed_best) typed_best = elapsed;
+        if (count != 0) printf("(counts disagree)\n");
+    }
+    generic_best *= 1e9 / num_elems;
+    typed_best *= 1e9 / num_elems;
+
+    printf("\n%-28s %8s %12s %10s\n", "elem_count", "sll", "SLL_DEFINE",
+           "speedup");
+    printf("%-28s %8.2f %12.2f %9.2fx\n", "pool, in order", generic_best,
+           typed_best, generic_best / typed_best);
+
+    sll_free(generic);
+    int_list_free(typed);
+}
+
+int
+main(int argc, const char *argv[])
+{
+    size_t num_elems = (argc > 1)? strtoul(argv[1], NULL, 10)
+                                 : DEFAULT_NUM_ELEMS;
+    size_t distance = (argc > 2)? strtoul(argv[2], NULL, 10)
+                                : DEFAULT_DISTANCE;
+
+    printf("Scanning %zu ints, prefetching %zu nodes ahead\n\n",
+           num_elems, distance);
+    printf("%-28s %8s %8s %8s %10s\n", "layout ns/elem", "none", "ahead",
+           "jump", "speedup");
+
+    bench("heap, in order", num_elems, 1, 0, 0, distance);
+    bench("pool, in order", num_elems, 1, 1, 0, distance);
+    bench("heap, shuffled links", num_elems, 1, 0, 1, distance);
+    bench("pool, shuffled links", num_elems, 1, 1, 1, distance);
+    bench("unrolled x16, in order", num_elems, UNROLLED_NODE_CAPACITY, 0, 0,
+          distance);
+    bench("unrolled x16, shuffled", num_elems, UNROLLED_NODE_CAPACITY, 0, 1,
+          distance);
+
+    bench_typed(num_elems);
+
+    return 0;
+}
@@ -15,6 +15,17 @@
 #include <signal.h>
 
 #include "sll.h"
+#include "sll-typed.h"
+
+/* Every test runs against plain lists, unrolled lists holding this many
+ * elements per node, and plain lists allocating from a pool. */
+#define UNROLLED_NODE_CAPACITY 4
+
+static size_t elems_per_node = 1;
+static bool pooled = false;
+
+#define cmp_int_val(a, b) (((a) > (b)) - ((a) < (b)))
+SLL_DEFINE(int_list, int, cmp_int_val)
 
 static int
 cmp_int(const void *a, const void *b)
@@ -22,70 +33,70 @@ cmp_int(const void *a, const void *b)
     return *(const int *)a - *(const int *)b;
 }
 
-static void
-print_addr(void *elem, void *unused)
+static sll *
+new_int_list()
 {
-    printf("%p->", *(void **)elem);
+    sll *list = sll_init_unrolled(sizeof(int), elems_per_node, NULL);
+    if (pooled) sll_reserve(list, 0);
+    return list;
 }
 
-static void
-print_double(void *elem, void *unused)
+/* A new list whose nodes can be moved to and from other's. */
+static sll *
+new_int_list_like(sll *other)
 {
-    printf("%.2f->", *(double *)elem);
+    sll *list = new_int_list();
+    if (pooled) sll_use_pool(list, other->pool);
+    return list;
 }
 
-static void
-print_int(void *elem, void *unused)
+static sll *
+build_int_list(int start, int end)
 {
-    printf("%d->", *(int *)elem);
+    sll *list = new_int_list();
+
+    for (int i = end - 1; i >= start; i--)
+    {
+        sll_push(list, &i);
+    }
+
+    return list;
 }
 
 static void
-print_list(node *list, sll_map_fn print_fn)
+check_int(void *elem, void *aux_data)
 {
-    sll_map(list, print_fn, NULL);
-    printf("NULL\n");
+    int *expected = aux_data;
+    assert(*(int *)elem == (*expected)++);
 }
 
-static node *
-build_node(void *elem, size_t elem_size)
+static bool
+verify_int_list(sll *list, int start, int end)
 {
-    node *n = calloc(1, sizeof(node) + elem_size);
-    if (n == NULL) {
-        // handle out-of-memory error
-    }
-    memcpy(n->data, elem, elem_size);
-    return n;
-}
+    // The cached tail must be the last node
+    node_t *last = NULL;
+    for (node_t *n = list->head; n != NULL; n = n->next) last = n;
+    if (list->tail != last) return false;
 
-static node *
-build_int_list(int start, int end)
-{
-    node *list = NULL;
-    node **last_ref = &list;
+    // check_int asserts on any mismatch
+    int next = start;
+    sll_map(list, check_int, &next);
 
-    for (; start < end; start++)
-    {
-        node *n = build_node(&start, sizeof(start));
-        sll_push(last_ref, n);
-        last_ref = &((*last_ref)->next);
-    }
-
-    return list;
+    // If we haven't reached the end of the expected range, error!
+    return next == end && sll_length(list) == (size_t)(end - start);
 }
 
+/* Like verify_int_list, for lists holding exactly expected[0..n). */
 static bool
-verify_int_list(node *list, int start, int end)
+verify_int_array(sll *list, const int *expected, size_t n)
 {
-    for (node *cur = list; cur != NULL && start <= end; cur = cur->next, start++)
+    node_t *last = NULL;
+    for (node_t *cur = list->head; cur != NULL; cur = cur->next) last = cur;
+    if (list->tail != last || sll_length(list) != n) return false;
+    for (size_t i = 0; i < n; i++)
     {
-        // If the data doesn't match, error!
-        if (*(int *)cur->data != start) return false;
+        if (*(int *)sll_ith(list, i) != expected[i]) return false;
     }
-
-    // If we haven't reached the end of the expected range, error!
-    if (start < end) return false;
-
     return true;
 }
 
@@ -95,16 +106,16 @@ test_push()
     printf("Testing sll_push()\n------------------\n");
 
     printf("Pushing ints 1-100 onto the list...");
-    node *list = build_int_list(0, 100);
+    sll *list = build_int_list(0, 100);
     printf("OK!\n");
 
     printf("Verifying everything's in the list....");
     assert(verify_int_list(list, 0, 100));
     printf("OK!\n");
 
-    sll_free(list, NULL);
+    sll_free(list);
 
-    printf("All good with sll_push()!\n\n");    
+    printf("All good with sll_push()!\n\n");
 }
 
 static void
@@ -113,72 +124,146 @@ test_pop()
     printf("Testing sll_pop()\n-----------------\n");
 
     printf("Pushing 100 ints (0-99) onto the list...");
-    node *list = build_int_list(0, 100);
+    sll *list = build_int_list(0, 100);
     printf("OK!\n");
 
     printf("Popping everything out of the list...");
     for (int i = 0; i < 100; i++) {
-        assert(list != NULL);
-        node *n = sll_pop(&list);
-        assert(i == *(int *)n->data);
-        free(n);
+        assert(list->head != NULL);
+        int *elem = sll_pop(list);
+        assert(i == *elem);
+        free(elem);
     }
-    assert(list == NULL);
+    assert(list->head == NULL);
     printf("OK!\n");
 
     /*printf("Trying to pop an empty list...");
-    sll_pop(&list);
+    sll_pop(list);
     printf("OK!\n");*/
 
+    sll_free(list);
+
     printf("All good with sll_pop()!\n\n");
 }
 
+static void
+test_pop_into()
+{
+    printf("Testing sll_pop_into()\n----------------------\n");
+
+    printf("Draining 0-99 into a local...");
+    sll *list = build_int_list(0, 100);
+    for (int i = 0; i < 100; i++) {
+        int elem;
+        sll_pop_into(list, &elem);
+        assert(elem == i);
+        assert(sll_length(list) == (size_t)(99 - i));
+    }
+    assert(verify_int_list(list, 0, 0));
+    printf("OK!\n");
+
+    sll_free(list);
+
+    printf("All good with sll_pop_into()!\n\n");
+}
+
+static void
+test_detach_range()
+{
+    printf("Testing sll_detach_range()\n--------------------------\n");
+
+    printf("Popping the first 10 of 0-99...");
+    sll *list = build_int_list(0, 100);
+    sll *range = sll_pop_n(list, 10);
+    assert(verify_int_list(range, 0, 10));
+    assert(verify_int_list(list, 10, 100));
+    sll_free(range);
+    printf("OK!\n");
+
+    printf("Detaching from the middle and the end...");
+    range = sll_detach_range(list, 15, 30);
+    assert(verify_int_list(range, 25, 55));
+    sll *tail = sll_detach_range(list, 15, 45);
+    assert(verify_int_list(tail, 55, 100));
+    assert(verify_int_list(list, 10, 25));
+    sll_concat(list, range);
+    sll_concat(list, tail);
+    assert(verify_int_list(list, 10, 100));
+    sll_free(range);
+    sll_free(tail);
+    printf("OK!\n");
+
+    printf("Detaching nothing and everything...");
+    range = sll_detach_range(list, 3, 0);
+    assert(verify_int_list(range, 0, 0));
+    sll_free(range);
+    range = sll_pop_n(list, sll_length(list));
+    assert(verify_int_list(list, 0, 0));
+    assert(sll_length(range) == 90);
+    int elem = 1000;
+    sll_push(list, &elem);
+    sll_append(range, &elem);
+    assert(*(int *)sll_ith(range, 89) == 99);
+    assert(*(int *)sll_ith(range, 90) == 1000);
+    sll_free(range);
+    printf("OK!\n");
+
+    sll_free(list);
+
+    printf("All good with sll_detach_range()!\n\n");
+}
+
 static void
 test_insert_after()
 {
-    printf("Testing sll_insert_after()\n--------------------------\n");
+    printf("Testing insert_after()\n----------------------\n");
 
-    node *list = NULL;
+    node_t *list = NULL;
 
-    node n, o;
-    sll_push(&list, &n);
-    sll_insert_after(&n, &o);
+    node_t n, o;
+    push(&list, &n);
+    insert_after(&n, &o);
+    assert(list == &n && n.next == &o && o.next == NULL);
 
-    printf("All good with sll_insert_after()!\n\n");
+    printf("All good with insert_after()!\n\n");
 }
 
 static void
 test_remove_after()
 {
-    printf("Testing sll_remove_after()\n--------------------------\n");
+    printf("Testing remove_after()\n----------------------\n");
+
+    node_t *list = NULL;
+
+    node_t n, o;
+    push(&list, &o);
+    push(&list, &n);
+    assert(remove_after(&n) == &o);
+    assert(remove_after(&n) == NULL);
 
-    printf("All good with sll_remove_after()!\n\n");
+    printf("All good with remove_after()!\n\n");
 }
 
 static void
 test_find_last()
 {
-    printf("Testing sll_find_last()\n-----------------------\n");
+    printf("Testing the last node\n---------------------\n");
 
-    node *list = NULL;
-
-    printf("Ensure last element of empty list is NULL...");
-    assert(sll_find_last(list) == NULL);
-    printf("OK!\n");
+    node_t *list = NULL;
 
     printf("Ensure last elem of a single-elem list is that elem...");
-    node n;
-    sll_push(&list, &n);
-    assert(sll_find_last(list) == &n);
+    node_t n;
+    push(&list, &n);
+    assert(ith(list, length(list) - 1) == &n);
     printf("OK!\n");
 
     printf("Ensure last elem of two-elem list is the second elem...");
-    node o;
-    sll_push(&list, &o);
-    assert(sll_find_last(list) == &n);
+    node_t o;
+    push(&list, &o);
+    assert(ith(list, length(list) - 1) == &n);
     printf("OK!\n");
 
-    printf("All good with sll_find_last()!\n\n");
+    printf("All good with the last node!\n\n");
 }
 
 static void
@@ -186,42 +271,80 @@ test_append()
 {
     printf("Testing sll_append()\n---------------\n");
 
-    node *list = NULL;
+    sll *list = new_int_list();
 
     // Append some ints to list
     for (int i = 0; i < 100; i++) {
-        node *n = build_node(&i, sizeof(i));
-        sll_append(&list, n);
+        sll_append(list, &i);
     }
 
     assert(verify_int_list(list, 0, 100));
     printf("OK!\n");
 
-    sll_free(list, NULL);
+    printf("Appending after pops and removals...");
+    for (int i = 0; i < 10; i++) {
+        free(sll_pop(list));
+        sll_remove_ith(list, sll_length(list) - 1);
+    }
+    for (int i = 90; i < 100; i++) {
+        sll_append(list, &i);
+    }
+    assert(verify_int_list(list, 10, 100));
+    printf("OK!\n");
+
+    sll_free(list);
 
     printf("All good with sll_append()!\n\n");
 }
 
+static void
+test_concat()
+{
+    printf("Testing sll_concat()\n--------------------\n");
+
+    printf("Splicing 0-49 and 50-99 together...");
+    sll *front = build_int_list(0, 50);
+    sll *back = new_int_list_like(front);
+    for (int i = 50; i < 100; i++) sll_append(back, &i);
+    sll_concat(front, back);
+    assert(verify_int_list(front, 0, 100));
+    assert(verify_int_list(back, 0, 0));
+    printf("OK!\n");
+
+    printf("Splicing onto and from empty lists...");
+    sll_concat(back, front);
+    assert(verify_int_list(back, 0, 100));
+    sll_concat(back, front);
+    assert(verify_int_list(back, 0, 100));
+    int i = 100;
+    sll_append(back, &i);
+    assert(verify_int_list(back, 0, 101));
+    printf("OK!\n");
+
+    sll_free(front);
+    sll_free(back);
+
+    printf("All good with sll_concat()!\n\n");
+}
+
 static void
 test_ith()
 {
     printf("Testing sll_ith()\n-----------------\n");
 
-    node *list = NULL;
-
     printf("Ensure sll_ith() on empty list errors...");
-    //node *n = sll_ith(list, 0);
+    //sll_ith(list, 0);
     printf("OK!\n");
 
     printf("Push 0-10 onto list, ensure that we can find them...");
-    list = build_int_list(0, 10);
+    sll *list = build_int_list(0, 10);
     for (int i = 0; i < 10; i++)
     {
-        assert(*(int *)(sll_ith(list, i)->data) == i);    
+        assert(*(int *)sll_ith(list, i) == i);
     }
     printf("OK!\n");
 
-    sll_free(list, NULL);
+    sll_free(list);
 
     printf("All good with sll_ith()!\n\n");
 }
@@ -231,24 +354,30 @@ test_insert_ith()
 {
     printf("Testing sll_insert_ith()\n------------------------\n");
 
-    node *list = NULL;
-
-    int elem = 0;
-    node *zero = build_node(&elem, sizeof(elem));
-
-    elem = 1;
-    node *one = build_node(&elem, sizeof(elem));
-
-    elem = 2;
-    node *two = build_node(&elem, sizeof(elem));
+    sll *list = new_int_list();
 
-    sll_insert_ith(&list, zero, 0);
-    sll_insert_ith(&list, two, 1);
-    sll_insert_ith(&list, one, 1);
+    int zero = 0, one = 1, two = 2;
+    sll_insert_ith(list, 0, &zero);
+    sll_insert_ith(list, 1, &two);
+    sll_insert_ith(list, 1, &one);
 
     assert(verify_int_list(list, 0, 3));
 
-    sll_free(list, NULL);
+    printf("Filling in the odds between 0-100 evens...");
+    sll_free(list);
+    list = new_int_list();
+    for (int i = 0; i < 100; i += 2)
+    {
+        sll_insert_ith(list, i / 2, &i);
+    }
+    for (int i = 1; i < 100; i += 2)
+    {
+        sll_insert_ith(list, i, &i);
+    }
+    assert(verify_int_list(list, 0, 100));
+    printf("OK!\n");
+
+    sll_free(list);
 
     printf("All good with sll_insert_ith()!\n\n");
 }
@@ -258,6 +387,29 @@ test_remove_ith()
 {
     printf("Testing sll_remove_ith()\n----------------\n");
 
+    printf("Removing the odds from 0-100...");
+    sll *list = build_int_list(0, 100);
+    for (int i = 1; i < 51; i++)
+    {
+        sll_remove_ith(list, i);
+    }
+    assert(sll_length(list) == 50);
+    for (int i = 0; i < 50; i++)
+    {
+        assert(*(int *)sll_ith(list, i) == 2 * i);
+    }
+    printf("OK!\n");
+
+    printf("Removing everything from the front...");
+    while (sll_length(list) > 0)
+    {
+        sll_remove_ith(list, 0);
+    }
+    assert(list->head == NULL);
+    printf("OK!\n");
+
+    sll_free(list);
+
     printf("All good with sll_remove_ith()!\n\n");
 }
 
@@ -266,12 +418,14 @@ test_length()
 {
     printf("Testing sll_length()\n--------------------\n");
 
-    node *list = NULL;
+    sll *list = new_int_list();
 
     printf("Make sure empty list has length 0...");
     assert(sll_length(list) == 0);
     printf("OK!\n");
 
+    sll_free(list);
+
     printf("Pushing 100 ints (0-99) onto the list...");
     list = build_int_list(0, 100);
     printf("OK!\n");
@@ -280,15 +434,17 @@ test_length()
     assert(sll_length(list) == 100);
     printf("OK!\n");
 
-    sll_free(list, NULL);
+    sll_free(list);
 
     printf("All good with sll_length()!\n\n");
 }
 
+static int freed_count;
+
 static void
 check_free(void *elem)
 {
-
+    freed_count++;
 }
 
 static void
@@ -296,44 +452,95 @@ test_free()
 {
     printf("Testing sll_free()\n------------------\n");
 
-    node *list = NULL;
+    sll *list = sll_init_unrolled(sizeof(int), elems_per_node, check_free);
 
     printf("Pushing 100 ints (0-99) onto the list...");
-    list = build_int_list(0, 100);
+    for (int i = 0; i < 100; i++)
+    {
+        sll_push(list, &i);
+    }
     printf("OK!\n");
 
     printf("Freeing the list...");
-    sll_free(list, check_free);
+    freed_count = 0;
+    sll_free(list);
+    assert(freed_count == 100);
     printf("OK!\n");
 
     printf("All good with sll_free()!\n\n");
 }
 
+static void
+test_reserve()
+{
+    printf("Testing sll_reserve()\n---------------------\n");
+
+    printf("Reserving 100 nodes and pushing 0-99...");
+    sll *list = new_int_list();
+    sll_reserve(list, 100);
+    pool_t *pool = list->pool;
+    for (int i = 99; i >= 0; i--)
+    {
+        sll_push(list, &i);
+    }
+    assert(list->pool == pool);
+    assert(verify_int_list(list, 0, 100));
+    printf("OK!\n");
+
+    printf("Making sure popped nodes get recycled...");
+    node_t *head = list->head;
+    for (int i = 0; i <= UNROLLED_NODE_CAPACITY; i++)
+    {
+        free(sll_pop(list));
+    }
+    for (int i = UNROLLED_NODE_CAPACITY; i >= 0; i--)
+    {
+        sll_push(list, &i);
+    }
+    assert(list->head == head);
+    assert(verify_int_list(list, 0, 100));
+    printf("OK!\n");
+
+    printf("Sharing the pool with a second list...");
+    sll *other = new_int_list();
+    sll_use_pool(other, list->pool);
+    assert(pool_refs(list->pool) == 2);
+    for (int i = 0; i < 100; i++)
+    {
+        sll_push(other, &i);
+    }
+    sll_free(list);
+    assert(pool_refs(other->pool) == 1);
+    assert(sll_length(other) == 100);
+    sll_free(other);
+    printf("OK!\n");
+
+    printf("All good with sll_reserve()!\n\n");
+}
+
 static void
 test_search()
 {
     printf("Testing search...");
 
-    node *list = NULL;
+    sll *list = new_int_list();
 
     // Make sure we can't search an empty list
     int a = 7;
-    assert(sll_search(NULL, &a, cmp_int) == NULL);
+    assert(sll_search(list, &a, cmp_int) == NULL);
 
     // Make sure we can do a simple list
-    node *n = build_node(&a, sizeof(a));
-    sll_push(&list, n);
-    assert(*(int *)(sll_search(list, &a, cmp_int)->data) == a);
+    sll_push(list, &a);
+    assert(*(int *)sll_search(list, &a, cmp_int) == a);
 
-    sll_free(list, NULL);
-    list = NULL;
+    sll_free(list);
 
     // Prepend some ints to list
     list = build_int_list(0, 100);
 
     // Make sure we can successfully find everything in the list
     for (int i = 0; i < 100; i++) {
-        assert(*(int *)(sll_search(list, &i, cmp_int)->data) == i);
+        assert(*(int *)sll_search(list, &i, cmp_int) == i);
     }
 
     // Make sure we can't find other things in the list
@@ -345,7 +552,7 @@ test_search()
         assert(sll_search(list, &i, cmp_int) == NULL);
     }
 
-    sll_free(list, NULL);
+    sll_free(list);
 
     printf("OK!\n");
 }
@@ -355,18 +562,16 @@ test_elem_count()
 {
     printf("Testing sll_elem_count()\n------------------------\n");
 
-    node *list = build_int_list(0, 10);
+    sll *list = build_int_list(0, 10);
 
     // Push all evens onto list again
     for (int i = 0; i < 10; i += 2) {
-        node *n = build_node(&i, sizeof(i));
-        sll_push(&list, n);
+        sll_push(list, &i);
     }
 
     // Push all multiples of 4 onto list one more time
     for (int i = 0; i < 10; i += 4) {
-        node *n = build_node(&i, sizeof(i));
-        sll_push(&list, n);
+        sll_push(list, &i);
     }
 
     int one = 1, six = 6, eight = 8;
@@ -374,19 +579,85 @@ test_elem_count()
     assert(sll_elem_count(list, &six, cmp_int) == 2);
     assert(sll_elem_count(list, &eight, cmp_int) == 3);
 
-    sll_free(list, NULL);
+    sll_free(list);
 
     printf("All good with sll_elem_count()!\n\n");
 }
 
+static void
+sum_int(void *elem, void *aux_data)
+{
+    *(int *)aux_data += *(int *)elem;
+}
+
 static void
 test_map()
 {
     printf("Testing sll_map()\n-----------------\n");
 
+    sll *list = build_int_list(0, 100);
+    int sum = 0;
+    sll_map(list, sum_int, &sum);
+    assert(sum == 4950);
+    sll_free(list);
+
     printf("All good with sll_map()!\n\n");
 }
 
+static void
+test_prefetch()
+{
+    printf("Testing sll_init_prefetch()\n---------------------------\n");
+
+    for (int prefetch = SLL_PREFETCH_AHEAD; prefetch <= SLL_PREFETCH_JUMP;
+         prefetch++)
+    {
+        sll *list = sll_init_prefetch(sizeof(int), elems_per_node, prefetch,
+                                      3, NULL);
+        if (pooled) sll_reserve(list, 0);
+        for (int i = 0; i < 100; i++)
+        {
+            sll_append(list, &i);
+        }
+
+        // Scan before and after laying the jump pointers
+        for (int run = 0; run < 2; run++)
+        {
+            int sum = 0;
+            sll_map(list, sum_int, &sum);
+            assert(sum == 4950);
+            sll_build_prefetch(list);
+        }
+
+        // Leave some jump pointers stale
+        int zero = 0, fifty = 50, ninety_nine = 99;
+        sll_remove_ith(list, 50);
+        sll_push(list, &zero);
+        assert(sll_search(list, &fifty, cmp_int) == NULL);
+        assert(*(int *)sll_search(list, &ninety_nine, cmp_int) == 99);
+        assert(sll_elem_count(list, &zero, cmp_int) == 2);
+        int sum = 0;
+        sll_map(list, sum_int, &sum);
+        assert(sum == 4900);
+        assert(sll_length(list) == 100);
+
+        // Lists that prefetch the same way can share nodes at any distance
+        sll *other = sll_init_prefetch(sizeof(int), elems_per_node, prefetch,
+                                       SLL_MAX_PREFETCH, NULL);
+        if (pooled) sll_use_pool(other, list->pool);
+        sll_concat(other, list);
+        sll_build_prefetch(other);
+        sum = 0;
+        sll_map(other, sum_int, &sum);
+        assert(sum == 4900);
+        assert(sll_length(other) == 100);
+        sll_free(other);
+        sll_free(list);
+    }
+
+    printf("All good with sll_init_prefetch()!\n\n");
+}
+
 static void
 test_bubble_sort()
 {
@@ -399,55 +670,141 @@ static void
 test_sorted_insert()
 {
     printf("Testing sll_sorted_insert()\n---------------------------\n");
-    
-    node *list = build_int_list(5, 10);
+
+    sll *list = build_int_list(5, 10);
 
     int i = 4;
-    node *n = build_node(&i, sizeof(i));
-    sll_sorted_insert(&list, n, cmp_int);
+    sll_sorted_insert(list, &i, cmp_int);
 
     i = 2;
-    n = build_node(&i, sizeof(i));
-    sll_sorted_insert(&list, n, cmp_int);
+    sll_sorted_insert(list, &i, cmp_int);
 
     i = 10;
-    n = build_node(&i, sizeof(i));
-    sll_sorted_insert(&list, n, cmp_int);
+    sll_sorted_insert(list, &i, cmp_int);
 
     i = 12;
-    n = build_node(&i, sizeof(i));
-    sll_sorted_insert(&list, n, cmp_int);    
+    sll_sorted_insert(list, &i, cmp_int);
 
     i = 3;
-    n = build_node(&i, sizeof(i));
-    sll_sorted_insert(&list, n, cmp_int);
+    sll_sorted_insert(list, &i, cmp_int);
 
     i = 11;
-    n = build_node(&i, sizeof(i));
-    sll_sorted_insert(&list, n, cmp_int);
+    sll_sorted_insert(list, &i, cmp_int);
 
     assert(verify_int_list(list, 2, 13));
     printf("OK!\n");
 
-    sll_free(list, NULL);
+    sll_free(list);
 
     printf("All good with sll_sorted_insert()!\n\n");
 }
 
+static void
+test_index()
+{
+    printf("Testing sll_index()\n-------------------\n");
+
+    if (elems_per_node > 1)
+    {
+        printf("Skipping, unrolled lists aren't indexed\n\n");
+        return;
+    }
+
+    printf("Sorted-inserting 0-9999 twice each, shuffled...");
+    sll *list = new_int_list();
+    sll_index(list, cmp_int);
+    for (int i = 0; i < 20000; i++)
+    {
+        int j = (int)(((long)i * 7919) % 20000) / 2;
+        sll_sorted_insert(list, &j, cmp_int);
+    }
+    assert(list->index != NULL);
+    assert(sll_length(list) == 20000);
+    for (int i = 0; i < 20000; i++)
+    {
+        assert(*(int *)sll_ith(list, i) == i / 2);
+    }
+    printf("OK!\n");
+
+    printf("Searching and counting through the index...");
+    for (int i = 0; i < 10000; i++)
+    {
+        assert(*(int *)sll_search(list, &i, cmp_int) == i);
+        assert(sll_elem_count(list, &i, cmp_int) == 2);
+    }
+    int missing = 10000;
+    assert(sll_search(list, &missing, cmp_int) == NULL);
+    assert(sll_elem_count(list, &missing, cmp_int) == 0);
+    missing = -1;
+    assert(sll_search(list, &missing, cmp_int) == NULL);
+    printf("OK!\n");
+
+    printf("Keeping the index current through removals...");
+    for (int i = 0; i < 100; i++)
+    {
+        int elem;
+        sll_pop_into(list, &elem);
+        assert(elem == i / 2);
+    }
+    for (int i = 0; i < 100; i++)
+    {
+        sll_remove_ith(list, i);
+    }
+    for (int i = 50; i < 150; i++)
+    {
+        assert(sll_elem_count(list, &i, cmp_int) == 1);
+    }
+    sll_remove_duplicates(list, cmp_int);
+    assert(list->index != NULL);
+    assert(sll_length(list) == 9950);
+    for (int i = 50; i < 10000; i++)
+    {
+        assert(sll_elem_count(list, &i, cmp_int) == 1);
+    }
+    printf("OK!\n");
+
+    printf("Dropping the index on an unsorted push...");
+    sll_push(list, &missing);
+    assert(list->index == NULL);
+    assert(*(int *)sll_search(list, &missing, cmp_int) == -1);
+    printf("OK!\n");
+
+    sll_free(list);
+
+    printf("All good with sll_index()!\n\n");
+}
+
 static void
 test_insert_sort()
 {
     printf("Testing sll_insert_sort()\n-------------------------\n");
 
-    node *list = build_int_list(0, 10);
+    if (elems_per_node > 1)
+    {
+        printf("Skipping, unrolled lists aren't relinked\n\n");
+        return;
+    }
 
+    sll *list = build_int_list(0, 10);
+
+    sll_insert_sort(list, cmp_int);
 
-    sll_insert_sort(&list, cmp_int);
-    
     assert(verify_int_list(list, 0, 10));
     printf("OK!\n");
 
-    sll_free(list, NULL);
+    sll_free(list);
+
+    printf("Sorting 0-99 pushed in a shuffled order...");
+    list = new_int_list();
+    for (int i = 0; i < 100; i++)
+    {
+        int j = (i * 37) % 100;
+        sll_push(list, &j);
+    }
+    sll_insert_sort(list, cmp_int);
+    assert(verify_int_list(list, 0, 100));
+    sll_free(list);
+    printf("OK!\n");
 
     printf("All good with sll_insert_sort()!\n\n");
 }
@@ -458,33 +815,42 @@ test_front_back_split()
     printf("Testing sll_front_back_split()\n------------------------------\n");
 
     printf("Checking the empty list...");
-    node *list = NULL;
-    node *front, *back;
-    sll_front_back_split(list, &front, &back);
-    assert(front == NULL);
-    assert(back == NULL);
+    sll *list = new_int_list();
+    sll *front = new_int_list_like(list), *back = new_int_list_like(list);
+    sll_front_back_split(list, front, back);
+    assert(front->head == NULL);
+    assert(back->head == NULL);
     printf("OK!\n");
 
     printf("Checking a single-elem list...");
     int i = 7;
-    node *n = build_node(&i, sizeof(i));
-    sll_push(&list, n);
-    sll_front_back_split(list, &front, &back);
-    assert(front == n);
-    assert(back == NULL);
-    printf("OK!\n");
-
-    printf("Checking a two-elem list...");
-    
+    sll_push(list, &i);
+    sll_front_back_split(list, front, back);
+    assert(*(int *)sll_ith(front, 0) == 7);
+    assert(sll_length(front) == 1);
+    assert(back->head == NULL);
     printf("OK!\n");
 
-    printf("Checking a three-elem list...");
-
-    printf("OK!\n");
+    for (int len = 2; len <= 9; len++)
+    {
+        printf("Checking a %d-elem list...", len);
+        sll_free(list);
+        sll_free(front);
+        sll_free(back);
+        list = build_int_list(0, len);
+        front = new_int_list_like(list);
+        back = new_int_list_like(list);
+        sll_front_back_split(list, front, back);
+        assert(verify_int_list(list, 0, 0));
+        assert(verify_int_list(front, 0, (len + 1) / 2));
+        assert(verify_int_list(back, (len + 1) / 2, len));
+        printf("OK!\n");
+    }
 
-    printf("Checking a four-elem list...");
+    sll_free(list);
+    sll_free(front);
+    sll_free(back);
 
-    printf("OK!\n");
     printf("All good with sll_front_back_split()!\n\n");
 }
 
@@ -494,72 +860,140 @@ test_remove_duplicates()
     printf("Testing sll_remove_duplicates()\n-------------------------------\n");
 
     printf("Checking an empty list...");
-    node *list = NULL;
-    sll_remove_duplicates(list, cmp_int, NULL);
+    sll *list = new_int_list();
+    sll_remove_duplicates(list, cmp_int);
     printf("OK!\n");
 
     printf("Checking a single-elem list...");
     int i = 7;
-    node *n = build_node(&i, sizeof(i));
-    sll_push(&list, n);
-    sll_remove_duplicates(list, cmp_int, NULL);
-    sll_free(list, NULL);
-    list = NULL;
+    sll_push(list, &i);
+    sll_remove_duplicates(list, cmp_int);
+    assert(sll_length(list) == 1);
+    sll_free(list);
+    list = new_int_list();
     printf("OK!\n");
 
     printf("Checking a list with no duplicates...");
     for (int i = 0; i < 10; i++)
     {
-        node *n = build_node(&i, sizeof(i));
-        sll_push(&list, n);
+        sll_push(list, &i);
     }
-    sll_remove_duplicates(list, cmp_int, NULL);
+    sll_remove_duplicates(list, cmp_int);
     assert(sll_length(list) == 10);
-    sll_free(list, NULL);
-    list = NULL;
+    sll_free(list);
+    list = new_int_list();
     printf("OK!\n");
 
     printf("Checking a list with all duplicates...");
     for (int i = 0; i < 4; i++)
     {
         int j = 7;
-        node *n = build_node(&j, sizeof(j));
-        sll_push(&list, n);
+        sll_push(list, &j);
     }
-    sll_remove_duplicates(list, cmp_int, NULL);
+    sll_remove_duplicates(list, cmp_int);
     assert(sll_length(list) == 1);
-    sll_free(list, NULL);
-    list = NULL;
+    sll_free(list);
+    list = new_int_list();
     printf("OK!\n");
 
     printf("Checking a list with half duplicates...");
     for (int i = 0; i < 5; i++)
     {
-        node *n = build_node(&i, sizeof(i));
-        sll_push(&list, n);
+        sll_push(list, &i);
 
         if (i % 2 == 0)
         {
-            n = build_node(&i, sizeof(i));
-            sll_push(&list, n);
+            sll_push(list, &i);
         }
     }
     assert(sll_length(list) == 8);
-    sll_remove_duplicates(list, cmp_int, NULL);
+    sll_remove_duplicates(list, cmp_int);
     assert(sll_length(list) == 5);
-    sll_free(list, NULL);
-    list = NULL;
+    for (int i = 0; i < 5; i++)
+    {
+        assert(*(int *)sll_ith(list, i) == 4 - i);
+    }
+    sll_free(list);
     printf("OK!\n");
 
     printf("All good with sll_remove_duplicates()!\n\n");
 }
 
+static void
+test_typed()
+{
+    printf("Testing SLL_DEFINE()\n--------------------\n");
+
+    int_list *list = int_list_init();
+    if (pooled) int_list_reserve(list, 0);
+
+    printf("Checking push, append and pop...");
+    int elem;
+    assert(!int_list_pop(list, &elem));
+    for (int i = 0; i < 5; i++)
+    {
+        int_list_push(list, i);
+        int_list_append(list, i);
+    }
+    assert(int_list_length(list) == 10);
+    assert(int_list_pop(list, &elem) && elem == 4);
+    assert(list->tail->elem == 4);
+    printf("OK!\n");
+
+    printf("Checking search and elem_count...");
+    int_list_push(list, 2);
+    assert(int_list_elem_count(list, 2) == 3);
+    assert(int_list_elem_count(list, 7) == 0);
+    assert(*int_list_search(list, 3) == 3);
+    assert(int_list_search(list, 7) == NULL);
+    while (int_list_pop(list, &elem)) {}
+    assert(list->head == NULL && list->tail == NULL);
+    printf("OK!\n");
+
+    printf("Checking sorted_insert and remove_duplicates...");
+    int values[] = {5, 1, 5, 9, 0, 9, 9, 3, 1};
+    for (int i = 0; i < 9; i++)
+    {
+        int_list_sorted_insert(list, values[i]);
+    }
+    int sorted[] = {0, 1, 1, 3, 5, 5, 9, 9, 9};
+    int i = 0;
+    for (int_list_node *n = list->head; n != NULL; n = n->next)
+    {
+        assert(n->elem == sorted[i++]);
+    }
+    assert(i == 9 && list->tail->elem == 9);
+    int_list_remove_duplicates(list);
+    int unique[] = {0, 1, 3, 5, 9};
+    i = 0;
+    for (int_list_node *n = list->head; n != NULL; n = n->next)
+    {
+        assert(n->elem == unique[i++]);
+    }
+    assert(i == 5 && int_list_length(list) == 5 && list->tail->elem == 9);
+    int_list_append(list, 10);
+    assert(list->tail->elem == 10);
+    int_list_free(list);
+    printf("OK!\n");
+
+    printf("All good with SLL_DEFINE()!\n\n");
+}
+
 static void
 test_move_node()
 {
     printf("Testing sll_move_node()\n-----------------------\n");
 
-    node *list = build_int_list(0, 10);
+    if (elems_per_node == 1)
+    {
+        sll *src = build_int_list(0, 10);
+        sll *dst = new_int_list_like(src);
+        sll_move_node(dst, src);
+        assert(*(int *)sll_ith(dst, 0) == 0);
+        assert(verify_int_list(src, 1, 10));
+        sll_free(src);
+        sll_free(dst);
+    }
 
     printf("All good with sll_move_node()!\n\n");
 }
@@ -580,11 +1014,121 @@ test_shuffle_merge()
     printf("All good with sll_shuffle_merge()!\n\n");
 }
 
+/* Payload for the stability tests: sorted by key, seq records the order
+ * the elements were pushed in. */
+struct keyed
+{
+    int key;
+    int seq;
+};
+
+static int
+cmp_key(const void *a, const void *b)
+{
+    return ((const struct keyed *)a)->key - ((const struct keyed *)b)->key;
+}
+
+static void
+check_stable(void *elem, void *aux_data)
+{
+    struct keyed *prev = aux_data;
+    struct keyed *cur = elem;
+    assert(prev->key < cur->key ||
+           (prev->key == cur->key && prev->seq < cur->seq));
+    *prev = *cur;
+}
+
 static void
 test_sorted_merge()
 {
     printf("Testing sll_sorted_merge()\n--------------------------\n");
 
+    if (elems_per_node > 1)
+    {
+        printf("Skipping, unrolled lists aren't relinked\n\n");
+        return;
+    }
+
+    printf("Merging the evens and odds from 0-100...");
+    sll *evens = new_int_list();
+    sll *odds = new_int_list_like(evens);
+    for (int i = 98; i >= 0; i -= 2)
+    {
+        int j = i + 1;
+        sll_push(evens, &i);
+        sll_push(odds, &j);
+    }
+    sll *merged = sll_sorted_merge(evens, odds, cmp_int);
+    assert(verify_int_list(merged, 0, 100));
+    assert(evens->head == NULL && odds->head == NULL);
+    sll_free(merged);
+    printf("OK!\n");
+
+    printf("Merging with an empty list...");
+    for (int i = 9; i >= 0; i--)
+    {
+        sll_push(odds, &i);
+    }
+    merged = sll_sorted_merge(evens, odds, cmp_int);
+    assert(verify_int_list(merged, 0, 10));
+    sll_free(merged);
+    printf("OK!\n");
+
+    printf("Making sure ties come from the first list...");
+    sll_free(evens);
+    sll_free(odds);
+    evens = sll_init(sizeof(struct keyed), NULL);
+    odds = sll_init(sizeof(struct keyed), NULL);
+    if (pooled)
+    {
+        sll_reserve(evens, 0);
+        sll_use_pool(odds, evens->pool);
+    }
+    for (int i = 9; i >= 0; i--)
+    {
+        struct keyed a = { i, 0 }, b = { i, 1 };
+        sll_push(evens, &a);
+        sll_push(odds, &b);
+    }
+    merged = sll_sorted_merge(evens, odds, cmp_key);
+    struct keyed prev = { -1, 0 };
+    sll_map(merged, check_stable, &prev);
+    sll_free(merged);
+    printf("OK!\n");
+
+    printf("Galloping through long runs from either side...");
+    sll *few = new_int_list();
+    sll *many = new_int_list_like(few);
+    for (int i = 999; i >= 0; i--)
+    {
+        if (i % 250 == 17)
+        {
+            sll_push(few, &i);
+        }
+        else
+        {
+            sll_push(many, &i);
+        }
+    }
+    merged = sll_sorted_merge(many, few, cmp_int);
+    assert(verify_int_list(merged, 0, 1000));
+    sll_free(merged);
+    for (int i = 499; i >= 0; i--)
+    {
+        int j = i + 500;
+        sll_push(few, &i);
+        sll_push(many, &j);
+    }
+    merged = sll_sorted_merge(many, few, cmp_int);
+    assert(verify_int_list(merged, 0, 1000));
+    sll_free(merged);
+    sll_free(few);
+    sll_free(many);
+    printf("OK!\n");
+
+    sll_free(evens);
+    sll_free(odds);
+
     printf("All good with sll_sorted_merge()!\n\n");
 }
 
@@ -593,14 +1137,233 @@ test_merge_sort()
 {
     printf("Testing sll_merge_sort()\n------------------------\n");
 
+    if (elems_per_node > 1)
+    {
+        printf("Skipping, unrolled lists aren't relinked\n\n");
+        return;
+    }
+
+    printf("Sorting the empty list...");
+    sll *list = new_int_list();
+    sll_merge_sort(list, cmp_int);
+    assert(list->head == NULL);
+    printf("OK!\n");
+
+    printf("Sorting sorted and reverse-sorted lists...");
+    sll_free(list);
+    list = build_int_list(0, 1000);
+    sll_merge_sort(list, cmp_int);
+    assert(verify_int_list(list, 0, 1000));
+    sll_reverse(list);
+    sll_merge_sort(list, cmp_int);
+    assert(verify_int_list(list, 0, 1000));
+    sll_free(list);
+    printf("OK!\n");
+
+    printf("Sorting 100000 shuffled ints...");
+    list = new_int_list();
+    for (int i = 0; i < 100000; i++)
+    {
+        int j = (int)(((long)i * 7919) % 100000);
+        sll_push(list, &j);
+    }
+    sll_merge_sort(list, cmp_int);
+    assert(verify_int_list(list, 0, 100000));
+    sll_free(list);
+    printf("OK!\n");
+
+    printf("Making sure equal keys keep their order...");
+    list = sll_init(sizeof(struct keyed), NULL);
+    if (pooled) sll_reserve(list, 0);
+    for (int i = 1000; i > 0; i--)
+    {
+        struct keyed k = { (i * 31) % 17, i };
+        sll_push(list, &k);
+    }
+    sll_merge_sort(list, cmp_key);
+    struct keyed prev = { -1, 0 };
+    sll_map(list, check_stable, &prev);
+    sll_free(list);
+    printf("OK!\n");
+
     printf("All good with sll_merge_sort()!\n\n");
 }
 
+static void
+test_sorted_merge_all()
+{
+    printf("Testing sll_sorted_merge_all()\n------------------------------\n");
+
+    if (elems_per_node > 1)
+    {
+        printf("Skipping, unrolled lists aren't relinked\n\n");
+        return;
+    }
+
+    printf("Merging residues mod 5, a block and an empty list...");
+    sll *lists[7];
+    lists[0] = new_int_list();
+    for (int i = 1; i < 7; i++)
+    {
+        lists[i] = new_int_list_like(lists[0]);
+    }
+    for (int i = 99; i >= 0; i--)
+    {
+        sll_push(lists[i % 5], &i);
+    }
+    for (int i = 199; i >= 100; i--)
+    {
+        sll_push(lists[6], &i);
+    }
+    sll *merged = sll_sorted_merge_all(lists, 7, cmp_int);
+    assert(verify_int_list(merged, 0, 200));
+    for (int i = 0; i < 7; i++)
+    {
+        assert(lists[i]->head == NULL && sll_length(lists[i]) == 0);
+    }
+    sll_free(merged);
+    printf("OK!\n");
+
+    printf("Merging all empty lists...");
+    merged = sll_sorted_merge_all(lists, 7, cmp_int);
+    assert(merged->head == NULL && merged->tail == NULL);
+    sll_free(merged);
+    for (int i = 0; i < 7; i++)
+    {
+        sll_free(lists[i]);
+    }
+    printf("OK!\n");
+
+    printf("Making sure ties come from the earlier list...");
+    sll *keyed[3];
+    keyed[0] = sll_init(sizeof(struct keyed), NULL);
+    if (pooled) sll_reserve(keyed[0], 0);
+    for (int i = 0; i < 3; i++)
+    {
+        if (i > 0) keyed[i] = sll_init(sizeof(struct keyed), NULL);
+        if (i > 0 && pooled) sll_use_pool(keyed[i], keyed[0]->pool);
+        for (int key = 29; key >= 0; key--)
+        {
+            struct keyed elem = { key / (i + 1), i * 100 + key };
+            sll_push(keyed[i], &elem);
+        }
+    }
+    merged = sll_sorted_merge_all(keyed, 3, cmp_key);
+    assert(sll_length(merged) == 90);
+    struct keyed prev = { -1, 0 };
+    sll_map(merged, check_stable, &prev);
+    sll_free(merged);
+    for (int i = 0; i < 3; i++)
+    {
+        sll_free(keyed[i]);
+    }
+    printf("OK!\n");
+
+    printf("All good with sll_sorted_merge_all()!\n\n");
+}
+
+/* Builds a sorted list of the values in [start, end) that are multiples
+ * of step, each repeated copies times. */
+static sll *
+build_multiples(sll *like, int start, int end, int step, int copies)
+{
+    sll *list = (like != NULL)? new_int_list_like(like) : new_int_list();
+    for (int i = start; i < end; i++)
+    {
+        if (i % step != 0) continue;
+        for (int c = 0; c < copies; c++)
+        {
+            sll_append(list, &i);
+        }
+    }
+    return list;
+}
+
 static void
 test_sorted_intersect()
 {
     printf("Testing sll_sorted_intersect()\n------------------------------\n");
 
+    if (elems_per_node > 1)
+    {
+        printf("Skipping, unrolled lists aren't relinked\n\n");
+        return;
+    }
+
+    // Every other index variant: none, on a, on b, on both
+    for (int indexed = 0; indexed < 4; indexed++)
+    {
+        printf("Intersecting multiples of 2 and 3 (index %d)...", indexed);
+        sll *a = build_multiples(NULL, 0, 60, 2, 1);
+        sll *b = build_multiples(NULL, 0, 60, 3, 1);
+        if (indexed & 1) sll_index(a, cmp_int);
+        if (indexed & 2) sll_index(b, cmp_int);
+        sll *common = sll_sorted_intersect(a, b, cmp_int);
+        int sixes[] = {0, 6, 12, 18, 24, 30, 36, 42, 48, 54};
+        assert(verify_int_array(common, sixes, 10));
+        assert(sll_length(a) == 20 && sll_length(b) == 20);
+        int seven = 7, eight = 8;
+        assert(sll_search(a, &seven, cmp_int) == NULL);
+        assert(*(int *)sll_search(a, &eight, cmp_int) == 8);
+        assert(sll_search(a, &sixes[3], cmp_int) == NULL);
+        sll_free(common);
+        sll_free(a);
+        sll_free(b);
+        printf("OK!\n");
+
+        printf("Intersecting a short list with a long one (index %d)...",
+               indexed);
+        a = build_multiples(NULL, 0, 10000, 1, 1);
+        b = build_multiples(a, 0, 10000, 1000, 1);
+        if (indexed & 1) sll_index(a, cmp_int);
+        if (indexed & 2) sll_index(b, cmp_int);
+        common = sll_sorted_intersect(b, a, cmp_int);
+        int thousands[] = {0, 1000, 2000, 3000, 4000, 5000, 6000, 7000,
+                           8000, 9000};
+        assert(verify_int_array(common, thousands, 10));
+        assert(b->head == NULL && b->tail == NULL && sll_length(b) == 0);
+        sll_free(common);
+        sll_free(b);
+
+        // And the other way round, taking the few common nodes out of a
+        b = build_multiples(a, 0, 10000, 2500, 1);
+        if (indexed & 2) sll_index(b, cmp_int);
+        common = sll_sorted_intersect(a, b, cmp_int);
+        int quarters[] = {0, 2500, 5000, 7500};
+        assert(verify_int_array(common, quarters, 4));
+        assert(sll_length(a) == 9996 && sll_length(b) == 4);
+        assert(*(int *)sll_ith(a, 0) == 1 && *(int *)sll_ith(a, 2499) == 2501);
+        sll_free(common);
+        sll_free(a);
+        sll_free(b);
+        printf("OK!\n");
+    }
+
+    printf("Keeping duplicates as many times as both lists have them...");
+    sll *a = build_multiples(NULL, 0, 10, 1, 3);
+    sll *b = build_multiples(NULL, 0, 10, 2, 2);
+    sll *common = sll_sorted_intersect(a, b, cmp_int);
+    int twice[] = {0, 0, 2, 2, 4, 4, 6, 6, 8, 8};
+    assert(verify_int_array(common, twice, 10));
+    assert(sll_length(a) == 20);
+    sll_free(common);
+    sll_free(a);
+    sll_free(b);
+    printf("OK!\n");
+
+    printf("Intersecting with an empty list...");
+    a = build_multiples(NULL, 0, 10, 1, 1);
+    b = new_int_list();
+    common = sll_sorted_intersect(a, b, cmp_int);
+    assert(common->head == NULL && sll_length(a) == 10);
+    sll_free(common);
+    common = sll_sorted_intersect(b, a, cmp_int);
+    assert(common->head == NULL && sll_length(a) == 10);
+    sll_free(common);
+    sll_free(a);
+    sll_free(b);
+    printf("OK!\n");
+
     printf("All good with sll_sorted_intersect()!\n\n");
 }
 
@@ -610,8 +1373,8 @@ test_reverse()
     printf("Testing sll_reverse()\n---------------------\n");
 
     printf("Checking an empty list...");
-    node *list = NULL;
-    sll_reverse(&list);
+    sll *list = new_int_list();
+    sll_reverse(list);
     printf("OK!\n");
 
     printf("Checking a single-elem list...");
@@ -621,17 +1384,16 @@ test_reverse()
 
     printf("Checking a ten-elem list...");
     for (int i = 0; i < 10; i++) {
-        node *n = build_node(&i, sizeof(i));
-        sll_push(&list, n);
+        sll_push(list, &i);
     }
 
-    sll_reverse(&list);
+    sll_reverse(list);
 
-    for (int i = 0; i < 10; i++, list = list->next) {
-        assert(i == *(int *)list->data);
-    }
+    assert(verify_int_list(list, 0, 10));
     printf("OK!\n");
 
+    sll_free(list);
+
     printf("All good with sll_reverse()!\n\n");
 }
 
@@ -651,17 +1413,20 @@ test_has_cycle()
     printf("All good with sll_has_cycle()!\n\n");
 }
 
-int
-main(int argc, const char *argv[])
+static void
+run_tests()
 {
     test_push();
     test_pop();
+    test_pop_into();
+    test_detach_range();
 
     test_insert_after();
     test_remove_after();
 
     test_find_last();
     test_append();
+    test_concat();
 
     test_ith();
     test_insert_ith();
@@ -669,16 +1434,20 @@ main(int argc, const char *argv[])
 
     test_length();
     test_free();
+    test_reserve();
     test_search();
     test_elem_count();
     test_map();
+    test_prefetch();
     test_bubble_sort();
 
     test_sorted_insert();
+    test_index();
     test_insert_sort();
 
-    //test_front_back_split();
+    test_front_back_split();
     test_remove_duplicates();
+    test_typed();
 
     test_move_node();
     test_alternating_split();
@@ -686,12 +1455,31 @@ main(int argc, const char *argv[])
     test_shuffle_merge();
     test_sorted_merge();
     test_merge_sort();
+    test_sorted_merge_all();
     test_sorted_intersect();
 
     test_reverse();
     test_reverse_recursive();
 
     test_has_cycle();
+}
+
+int
+main(int argc, const char *argv[])
+{
+    printf("=== Plain lists ===\n\n");
+    elems_per_node = 1;
+    run_tests();
+
+    printf("=== Unrolled lists (%d elems per node) ===\n\n",
+           UNROLLED_NODE_CAPACITY);
+    elems_per_node = UNROLLED_NODE_CAPACITY;
+    run_tests();
+
+    printf("=== Pooled lists ===\n\n");
+    elems_per_node = 1;
+    pooled = true;
+    run_tests();
 
     return 0;
 }
@@ -0,0 +1,234 @@
+/**
+ * sll-typed.h
+ * -----------
+ * Author: Nate Hardison
+ *
+ * Type-specialized singly-linked lists, generated at compile time.
+ *
+ *   #define cmp_int_val(a, b) (((a) > (b)) - ((a) < (b)))
+ *   SLL_DEFINE(int_list, int, cmp_int_val)
+ *
+ * declares an int_list type whose nodes hold an int directly, plus
+ * int_list_init, int_list_push and the rest below. Every operation is a
+ * static inline function that names cmp directly (a function taking two
+ * Ts by value or a function-like macro, returning <0, 0 or >0), so the
+ * compiler sees the comparison and the element copies and can inline,
+ * unroll and vectorize them: there is no sll_cmp_fn call and no memcpy of
+ * elem_size bytes per element. Use it for small, copyable element types
+ * on hot paths; the sll module remains the generic fallback for anything
+ * else (unrolled nodes, skip indexes, free_fns, elements of runtime size).
+ *
+ * Like sll, a typed list can take its nodes from a pool (see name_reserve).
+ */
+#include <assert.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "pool.h"
+
+#ifndef SLL_TYPED_H_
+#define SLL_TYPED_H_
+
+/* Chunk size for the pools that name_reserve creates. */
+#define SLL_TYPED_POOL_CHUNK_NODES 1024
+
+#define SLL_DEFINE(name, T, cmp)                                              \
+                                                                              \
+typedef struct name##_node                                                    \
+{                                                                             \
+  struct name##_node *next;                                                   \
+  T elem;                                                                     \
+} name##_node;                                                                \
+                                                                              \
+typedef struct                                                                \
+{                                                                             \
+  name##_node *head;                                                          \
+  name##_node *tail;                                                          \
+  size_t length;                                                              \
+  pool_t *pool; /* where nodes come from; NULL means the heap */              \
+} name;                                                                       \
+                                                                              \
+static inline name *name##_init(void)                                         \
+{                                                                             \
+  name *list = malloc(sizeof(name));                                          \
+  if (list == NULL)                                                           \
+  {                                                                           \
+    fprintf(stderr, "error: " #name "_init(): Out of heap memory\n");         \
+    exit(1);                                                                  \
+  }                                                                           \
+  list->head = NULL;                                                          \
+  list->tail = NULL;                                                          \
+  list->length = 0;                                                           \
+  list->pool = NULL;                                                          \
+  return list;                                                                \
+}                                                                             \
+                                                                              \
+static inline name##_node *name##_alloc_node(name *list, T elem)              \
+{                                                                             \
+  name##_node *n = (list->pool != NULL)? pool_alloc(list->pool)               \
+                                       : malloc(sizeof(name##_node));         \
+  if (n == NULL)                                                              \
+  {                                                                           \
+    fprintf(stderr, "error: " #name "_alloc_node(): Out of heap memory\n");   \
+    exit(1);                                                                  \
+  }                                                                           \
+  n->next = NULL;                                                             \
+  n->elem = elem;                                                             \
+  return n;                                                                   \
+}                                                                             \
+                                                                              \
+static inline void name##_release_node(name *list, name##_node *n)            \
+{                                                                             \
+  if (list->pool != NULL)                                                     \
+  {                                                                           \
+    pool_recycle(list->pool, n);                                              \
+  }                                                                           \
+  else                                                                        \
+  {                                                                           \
+    free(n);                                                                  \
+  }                                                                           \
+}                                                                             \
+                                                                              \
+/* Makes the next n pushes allocate from a pool rather than the heap. As      \
+ * with sll_reserve, only an empty list can switch to a pool. */              \
+static inline void name##_reserve(name *list, size_t n)                       \
+{                                                                             \
+  assert(list != NULL);                                                       \
+  if (list->pool == NULL)                                                     \
+  {                                                                           \
+    assert(list->head == NULL);                                               \
+    list->pool = pool_init(sizeof(name##_node), SLL_TYPED_POOL_CHUNK_NODES);  \
+  }                                                                           \
+  pool_reserve(list->pool, n);                                                \
+}                                                                             \
+                                                                              \
+static inline void name##_free(name *list)                                    \
+{                                                                             \
+  assert(list != NULL);                                                       \
+  if (list->pool != NULL)                                                     \
+  {                                                                           \
+    pool_release(list->pool);                                                 \
+  }                                                                           \
+  else                                                                        \
+  {                                                                           \
+    for (name##_node *n = list->head, *next; n != NULL; n = next)             \
+    {                                                                         \
+      next = n->next;                                                         \
+      free(n);                                                                \
+    }                                                                         \
+  }                                                                           \
+  free(list);                                                                 \
+}                                                                             \
+                                                                              \
+static inline size_t name##_length(const name *list)                          \
+{                                                                             \
+  assert(list != NULL);                                                       \
+  return list->length;                                                        \
+}                                                                             \
+                                                                              \
+static inline void name##_push(name *list, T elem)                            \
+{                                                                             \
+  assert(list != NULL);                                                       \
+  name##_node *n = name##_alloc_node(list, elem);                             \
+  n->next = list->head;                                                       \
+  list->head = n;                                                             \
+  if (list->tail == NULL) list->tail = n;                                     \
+  list->length++;                                                             \
+}                                                                             \
+                                                                              \
+static inline void name##_append(name *list, T elem)                          \
+{                                                                             \
+  assert(list != NULL);                                                       \
+  name##_node *n = name##_alloc_node(list, elem);                             \
+  if (list->tail == NULL)                                                     \
+  {                                                                           \
+    list->head = n;                                                           \
+  }                                                                           \
+  else                                                                        \
+  {                                                                           \
+    list->tail->next = n;                                                     \
+  }                                                                           \
+  list->tail = n;                                                             \
+  list->length++;                                                             \
+}                                                                             \
+                                                                              \
+/* Removes the first element into *elem; false if the list is empty. */       \
+static inline bool name##_pop(name *list, T *elem)                            \
+{                                                                             \
+  assert(list != NULL);                                                       \
+  assert(elem != NULL);                                                       \
+  name##_node *n = list->head;                                                \
+  if (n == NULL) return false;                                                \
+  list->head = n->next;                                                       \
+  if (list->head == NULL) list->tail = NULL;                                  \
+  list->length--;                                                             \
+  *elem = n->elem;                                                            \
+  name##_release_node(list, n);                                               \
+  return true;                                                                \
+}                                                                             \
+                                                                              \
+/* Returns the first element comparing equal to key, or NULL. */              \
+static inline T *name##_search(name *list, T key)                             \
+{                                                                             \
+  assert(list != NULL);                                                       \
+  for (name##_node *n = list->head; n != NULL; n = n->next)                   \
+  {                                                                           \
+    if (cmp(n->elem, key) == 0) return &n->elem;                              \
+  }                                                                           \
+  return NULL;                                                                \
+}                                                                             \
+                                                                              \
+static inline size_t name##_elem_count(name *list, T key)                     \
+{                                                                             \
+  assert(list != NULL);                                                       \
+  size_t count = 0;                                                           \
+  for (name##_node *n = list->head; n != NULL; n = n->next)                   \
+  {                                                                           \
+    count += (cmp(n->elem, key) == 0);                                        \
+  }                                                                           \
+  return count;                                                               \
+}                                                                             \
+                                                                              \
+/* Inserts after any equal elements, keeping an ascending list sorted. */     \
+static inline void name##_sorted_insert(name *list, T elem)                   \
+{                                                                             \
+  assert(list != NULL);                                                       \
+  /* Ascending input goes straight onto the tail. */                          \
+  if (list->tail == NULL || cmp(list->tail->elem, elem) <= 0)                 \
+  {                                                                           \
+    name##_append(list, elem);                                                \
+    return;                                                                   \
+  }                                                                           \
+  name##_node *n = name##_alloc_node(list, elem);                             \
+  name##_node **link = &list->head;                                           \
+  /* The tail is greater than elem, so this stops before the end. */          \
+  while (cmp((*link)->elem, elem) <= 0) link = &(*link)->next;                \
+  n->next = *link;                                                            \
+  *link = n;                                                                  \
+  list->length++;                                                             \
+}                                                                             \
+                                                                              \
+/* Drops all but the first of each run of equal elements. */                  \
+static inline void name##_remove_duplicates(name *list)                       \
+{                                                                             \
+  assert(list != NULL);                                                       \
+  name##_node *prev = list->head;                                             \
+  if (prev == NULL) return;                                                   \
+  for (name##_node *cur = prev->next; cur != NULL; cur = prev->next)          \
+  {                                                                           \
+    if (cmp(prev->elem, cur->elem) == 0)                                      \
+    {                                                                         \
+      prev->next = cur->next;                                                 \
+      name##_release_node(list, cur);                                         \
+      list->length--;                                                         \
+    }                                                                         \
+    else                                                                      \
+    {                                                                         \
+      prev = cur;                                                             \
+    }                                                                         \
+  }                                                                           \
+  list->tail = prev;                                                          \
+}
+
+#endif /* SLL_TYPED_H_ */
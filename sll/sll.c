@@ -2,33 +2,337 @@
 
 #include <assert.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
 #include "node.h"
+#include "pool.h"
+#include "skip.h"
+
+/* Prefetches are issued a cache line at a time. */
+#define CACHE_LINE 64
+
+#define ROUND_UP(x, a) (((x) + (a) - 1) / (a) * (a))
+
+/* A merge starts galloping once one side has won this many times running
+ * (timsort's threshold). */
+#define MIN_GALLOP 7
 
 /* Taken from Julie Zelenski, May 2012 */
 #define NOT_YET_IMPLEMENTED printf("%s() not yet implemented!\n", __FUNCTION__); exit(1);
 
-static node_t *build_node(void *elem, size_t elem_size)
+/* In an unrolled list each node_t's data is a block: a count followed by
+ * up to node_capacity elements packed back to back. */
+struct block
+{
+  size_t count;
+  char elems[];
+};
+
+static bool is_unrolled(const sll *list)
+{
+  return list->node_capacity > 1;
+}
+
+static struct block *block_of(node_t *n)
+{
+  return (struct block *)n->data;
+}
+
+static size_t node_size(const sll *list)
+{
+  size_t size = sizeof(node_t) + (is_unrolled(list)?
+                sizeof(struct block) + list->node_capacity * list->elem_size :
+                list->elem_size);
+  if (list->prefetch != SLL_PREFETCH_JUMP) return size;
+  return ROUND_UP(size, sizeof(node_t *)) + sizeof(node_t *);
+}
+
+/* In a SLL_PREFETCH_JUMP list every node_t ends in a jump pointer to the
+ * node prefetch_distance steps further on, as of the last
+ * sll_build_prefetch. */
+static node_t **jump_of(const sll *list, node_t *n)
+{
+  return (node_t **)((char *)n + node_size(list) - sizeof(node_t *));
+}
+
+/* Gets an uninitialized node_t from the list's pool, or from the heap if
+ * the list doesn't have one. */
+static node_t *alloc_node(sll *list)
 {
-  node_t *n = calloc(1, sizeof(node_t) + elem_size);
+  if (list->pool != NULL) return pool_alloc(list->pool);
+  node_t *n = malloc(node_size(list));
   if (n == NULL)
   {
-    /* TODO: handle out-of-memory error */
+    fprintf(stderr, "error: alloc_node(): Out of heap memory\n");
+    exit(1);
+  }
+  return n;
+}
+
+static void release_node(sll *list, node_t *n)
+{
+  if (list->pool != NULL)
+  {
+    pool_recycle(list->pool, n);
+  }
+  else
+  {
+    free(n);
+  }
+}
+
+/* The node-level primitives, plus upkeep of the list's cached tail. A
+ * NULL prev means the front of the list. */
+static void link_after(sll *list, node_t *prev, node_t *n)
+{
+  if (prev == NULL)
+  {
+    push(&list->head, n);
+  }
+  else
+  {
+    insert_after(prev, n);
+  }
+  if (prev == list->tail) list->tail = n;
+}
+
+static node_t *unlink_after(sll *list, node_t *prev)
+{
+  node_t *n = (prev == NULL)? pop(&list->head) : remove_after(prev);
+  if (n == list->tail) list->tail = prev;
+  return n;
+}
+
+/* Appends the chain head..tail of count elements to the end of list. */
+static void splice(sll *list, node_t *head, node_t *tail, size_t count)
+{
+  if (head == NULL) return;
+  if (list->tail == NULL)
+  {
+    list->head = head;
+  }
+  else
+  {
+    list->tail->next = head;
+  }
+  list->tail = tail;
+  list->length += count;
+}
+
+/* Called by every operation that can leave the list out of order (or
+ * that moves node_ts in bulk), rather than patching up the towers. */
+static void drop_index(sll *list)
+{
+  if (list->index != NULL)
+  {
+    skip_free(list->index);
+    list->index = NULL;
+  }
+}
+
+/* Whether the list's index can answer questions asked with cmp_fn. */
+static bool indexed_by(const sll *list, sll_cmp_fn cmp_fn)
+{
+  return list->index != NULL && skip_cmp(list->index) == cmp_fn;
+}
+
+#ifndef NDEBUG
+/* Whether nodes can move between the two lists. */
+static bool same_nodes(const sll *a, const sll *b)
+{
+  return a->elem_size == b->elem_size &&
+         a->node_capacity == b->node_capacity && a->pool == b->pool &&
+         (a->prefetch == SLL_PREFETCH_JUMP) ==
+         (b->prefetch == SLL_PREFETCH_JUMP);
+}
+#endif
+
+static node_t *build_node(sll *list, void *elem)
+{
+  node_t *n = alloc_node(list);
+  n->next = NULL;
+  if (list->prefetch == SLL_PREFETCH_JUMP) *jump_of(list, n) = NULL;
+  memcpy(n->data, elem, list->elem_size);
+  return n;
+}
+
+static node_t *build_block(sll *list)
+{
+  node_t *n = alloc_node(list);
+  n->next = NULL;
+  if (list->prefetch == SLL_PREFETCH_JUMP) *jump_of(list, n) = NULL;
+  block_of(n)->count = 0;
+  return n;
+}
+
+/* Number of elements held by n: always 1 unless the list is unrolled. */
+static size_t node_count(const sll *list, node_t *n)
+{
+  return is_unrolled(list)? block_of(n)->count : 1;
+}
+
+/* Address of the ith element held by n. */
+static void *node_elem(const sll *list, node_t *n, size_t i)
+{
+  if (!is_unrolled(list)) return n->data;
+  return block_of(n)->elems + i * list->elem_size;
+}
+
+/* Finds the node_t holding element i of an unrolled list, storing its
+ * predecessor (NULL for the head) in *prev and the element's offset
+ * within the block in *offset. i may be one past the last element. */
+static node_t *locate(const sll *list, size_t i, node_t **prev,
+                      size_t *offset)
+{
+  node_t *p = NULL;
+  node_t *n = list->head;
+  assert(n != NULL);
+  while (n->next != NULL && i >= block_of(n)->count)
+  {
+    i -= block_of(n)->count;
+    p = n;
+    n = n->next;
   }
-  memcpy(n->data, elem, elem_size);
+  assert(i <= block_of(n)->count);
+  *prev = p;
+  *offset = i;
   return n;
 }
 
+/* Moves the elements from offset i of n's block onwards into a new block
+ * linked in after n, and returns the new block. */
+static node_t *split_block(sll *list, node_t *n, size_t i)
+{
+  struct block *b = block_of(n);
+  node_t *rest = build_block(list);
+  block_of(rest)->count = b->count - i;
+  memcpy(node_elem(list, rest, 0), node_elem(list, n, i),
+         (b->count - i) * list->elem_size);
+  b->count = i;
+  link_after(list, n, rest);
+  return rest;
+}
+
+/* Inserts elem at offset i of n's block. A full block is split in half,
+ * except when appending past its end, where a fresh block is started. */
+static void block_insert(sll *list, node_t *n, size_t i, const void *elem)
+{
+  struct block *b = block_of(n);
+  if (b->count == list->node_capacity)
+  {
+    size_t keep = (i == b->count)? b->count : b->count / 2;
+    node_t *half = split_block(list, n, keep);
+    if (i >= keep)
+    {
+      n = half;
+      i -= keep;
+      b = block_of(half);
+    }
+  }
+  memmove(node_elem(list, n, i + 1), node_elem(list, n, i),
+          (b->count - i) * list->elem_size);
+  memcpy(node_elem(list, n, i), elem, list->elem_size);
+  b->count++;
+}
+
+/* Removes the element at offset i of n's block (prev is n's predecessor,
+ * or NULL at the head). An emptied block is unlinked and freed; one that
+ * drops below half full absorbs its successor when both fit in one. */
+static void block_remove(sll *list, node_t *prev, node_t *n, size_t i)
+{
+  struct block *b = block_of(n);
+  b->count--;
+  memmove(node_elem(list, n, i), node_elem(list, n, i + 1),
+          (b->count - i) * list->elem_size);
+  if (b->count == 0)
+  {
+    release_node(list, unlink_after(list, prev));
+  }
+  else if (b->count < list->node_capacity / 2 && n->next != NULL &&
+           b->count + block_of(n->next)->count <= list->node_capacity)
+  {
+    node_t *next = unlink_after(list, n);
+    memcpy(node_elem(list, n, b->count), node_elem(list, next, 0),
+           block_of(next)->count * list->elem_size);
+    b->count += block_of(next)->count;
+    release_node(list, next);
+  }
+}
+
+/* Called by the scans on reaching each node_t. Either way it only reads
+ * the list, and a wrong guess or a stale jump pointer just costs a
+ * useless prefetch: prefetches never fault. Returns n for the scans to
+ * step with, since GCC treats a function that only prefetches as having
+ * no effect and drops calls to it whose result goes unused. */
+static node_t *prefetch_ahead(const sll *list, node_t *n)
+{
+  if (n == NULL || list->prefetch == SLL_PREFETCH_NONE) return n;
+  char *ahead, *next = NULL;
+  if (list->prefetch == SLL_PREFETCH_AHEAD)
+  {
+    /* Where the pool, or the allocator, put the node_ts made after n. */
+    size_t stride = (list->pool != NULL)? pool_slot_size(list->pool)
+                                        : node_size(list);
+    ahead = (char *)n + list->prefetch_distance * stride;
+    if (is_unrolled(list)) next = (char *)n->next;
+  }
+  else
+  {
+    ahead = (char *)*jump_of(list, n);
+  }
+  for (size_t offset = 0; offset < node_size(list); offset += CACHE_LINE)
+  {
+    if (ahead != NULL) __builtin_prefetch(ahead + offset);
+    if (next != NULL) __builtin_prefetch(next + offset);
+  }
+  return n;
+}
+
+static void swap_elems(void *a, void *b, size_t elem_size)
+{
+  char *x = a, *y = b;
+  for (size_t k = 0; k < elem_size; k++)
+  {
+    char tmp = x[k];
+    x[k] = y[k];
+    y[k] = tmp;
+  }
+}
+
 sll *sll_init(size_t elem_size, sll_free_fn free_fn)
+{
+  return sll_init_unrolled(elem_size, 1, free_fn);
+}
+
+sll *sll_init_unrolled(size_t elem_size, size_t elems_per_node,
+                       sll_free_fn free_fn)
+{
+  return sll_init_prefetch(elem_size, elems_per_node, SLL_PREFETCH_NONE, 0,
+                           free_fn);
+}
+
+sll *sll_init_prefetch(size_t elem_size, size_t elems_per_node,
+                       enum sll_prefetch prefetch, size_t distance,
+                       sll_free_fn free_fn)
 {
   assert(elem_size > 0);
+  assert(elems_per_node > 0);
+  assert((prefetch == SLL_PREFETCH_NONE) == (distance == 0));
+  assert(distance <= SLL_MAX_PREFETCH);
   sll *list = malloc(sizeof(sll));
   list->head = NULL;
+  list->tail = NULL;
+  list->length = 0;
   list->elem_size = elem_size;
+  list->node_capacity = elems_per_node;
   list->free_fn = free_fn;
+  list->pool = NULL;
+  list->index = NULL;
+  list->prefetch = prefetch;
+  list->prefetch_distance = distance;
   return list;
 }
 
@@ -36,24 +340,102 @@ void sll_push(sll *list, void *elem)
 {
   assert(list != NULL);
   assert(elem != NULL);
-  node_t *n = build_node(elem, list->elem_size);
-  push(&list->head, n);
+  drop_index(list);
+  list->length++;
+  if (!is_unrolled(list))
+  {
+    link_after(list, NULL, build_node(list, elem));
+    return;
+  }
+  if (list->head == NULL ||
+      block_of(list->head)->count == list->node_capacity)
+  {
+    link_after(list, NULL, build_block(list));
+  }
+  block_insert(list, list->head, 0, elem);
+}
+
+void sll_append(sll *list, void *elem)
+{
+  assert(list != NULL);
+  assert(elem != NULL);
+  if (list->tail == NULL)
+  {
+    sll_push(list, elem);
+    return;
+  }
+  drop_index(list);
+  list->length++;
+  if (!is_unrolled(list))
+  {
+    link_after(list, list->tail, build_node(list, elem));
+    return;
+  }
+  block_insert(list, list->tail, block_of(list->tail)->count, elem);
+}
+
+void sll_concat(sll *dst, sll *src)
+{
+  assert(dst != NULL);
+  assert(src != NULL);
+  assert(same_nodes(dst, src));
+  drop_index(dst);
+  drop_index(src);
+  splice(dst, src->head, src->tail, src->length);
+  src->head = NULL;
+  src->tail = NULL;
+  src->length = 0;
 }
 
 void *sll_pop(sll *list)
 {
   assert(list != NULL);
-  node_t *n = pop(&list->head);
   void *elem = malloc(list->elem_size);
-  memcpy(elem, n->data, list->elem_size);
-  free(n);
+  if (elem == NULL)
+  {
+    fprintf(stderr, "error: sll_pop(): Out of heap memory\n");
+    exit(1);
+  }
+  sll_pop_into(list, elem);
   return elem;
 }
 
+void sll_pop_into(sll *list, void *elem)
+{
+  assert(list != NULL);
+  assert(list->head != NULL);
+  assert(elem != NULL);
+  list->length--;
+  memcpy(elem, node_elem(list, list->head, 0), list->elem_size);
+  if (is_unrolled(list))
+  {
+    block_remove(list, NULL, list->head, 0);
+    return;
+  }
+  if (list->index != NULL)
+  {
+    skip_remove(list->index, list->head);
+  }
+  release_node(list, unlink_after(list, NULL));
+}
+
 void *sll_ith(sll *list, int i)
 {
   assert(list != NULL);
   assert(i >= 0);
+  assert((size_t)i < list->length);
+  if ((size_t)i == list->length - 1)
+  {
+    return node_elem(list, list->tail, node_count(list, list->tail) - 1);
+  }
+  if (is_unrolled(list))
+  {
+    node_t *prev;
+    size_t offset;
+    node_t *n = locate(list, i, &prev, &offset);
+    assert(offset < block_of(n)->count);
+    return node_elem(list, n, offset);
+  }
   node_t *ith_node_t = ith(list->head, i);
   return ith_node_t->data;
 }
@@ -62,55 +444,189 @@ void sll_insert_ith(sll *list, int i, void *elem)
 {
   assert(list != NULL);
   assert(i >= 0);
+  assert((size_t)i <= list->length);
   assert(elem != NULL);
-  node_t *n = build_node(elem, list->elem_size);
   if (i == 0)
   {
-    push(&list->head, n);
+    sll_push(list, elem);
+    return;
   }
-  else
+  if ((size_t)i == list->length)
   {
-    node_t *prev = ith(list->head, i - 1);
-    insert_after(prev, n);
+    sll_append(list, elem);
+    return;
   }
+  drop_index(list);
+  list->length++;
+  if (is_unrolled(list))
+  {
+    node_t *prev;
+    size_t offset;
+    node_t *n = locate(list, i, &prev, &offset);
+    block_insert(list, n, offset, elem);
+    return;
+  }
+  link_after(list, ith(list->head, i - 1), build_node(list, elem));
 }
 
 void sll_remove_ith(sll *list, int i)
 {
   assert(list != NULL);
   assert(i >= 0);
-  NOT_YET_IMPLEMENTED
+  assert((size_t)i < list->length);
+  list->length--;
+  if (is_unrolled(list))
+  {
+    node_t *prev;
+    size_t offset;
+    node_t *n = locate(list, i, &prev, &offset);
+    assert(offset < block_of(n)->count);
+    if (list->free_fn != NULL)
+    {
+      list->free_fn(node_elem(list, n, offset));
+    }
+    block_remove(list, prev, n, offset);
+    return;
+  }
+  node_t *prev = (i == 0)? NULL : ith(list->head, i - 1);
+  if (list->index != NULL)
+  {
+    skip_remove(list->index, (prev == NULL)? list->head : prev->next);
+  }
+  node_t *n = unlink_after(list, prev);
+  if (list->free_fn != NULL)
+  {
+    list->free_fn(n->data);
+  }
+  release_node(list, n);
 }
 
 size_t sll_length(sll *list)
 {
   assert(list != NULL);
-  return length(list->head);
+  return list->length;
 }
 
 void sll_free(sll *list)
 {
   assert(list != NULL);
+  drop_index(list);
+  /* Nothing to visit in the nodes and nobody else allocating from the
+   * pool: dropping it hands back every node_t a chunk at a time. */
+  if (list->pool != NULL && list->free_fn == NULL &&
+      pool_refs(list->pool) == 1)
+  {
+    pool_release(list->pool);
+    free(list);
+    return;
+  }
   while (list->head != NULL)
   {
     node_t *n = pop(&list->head);
     if (list->free_fn != NULL)
     {
-      list->free_fn(n->data);
+      for (size_t i = 0; i < node_count(list, n); i++)
+      {
+        list->free_fn(node_elem(list, n, i));
+      }
     }
-    free(n);
+    release_node(list, n);
+  }
+  if (list->pool != NULL)
+  {
+    pool_release(list->pool);
   }
   free(list);
 }
 
+void sll_use_pool(sll *list, pool_t *pool)
+{
+  assert(list != NULL);
+  assert(pool != NULL);
+  assert(list->head == NULL);
+  assert(pool_slot_size(pool) >= node_size(list));
+  pool_retain(pool);
+  if (list->pool != NULL)
+  {
+    pool_release(list->pool);
+  }
+  list->pool = pool;
+}
+
+void sll_reserve(sll *list, size_t n)
+{
+  assert(list != NULL);
+  if (list->pool == NULL)
+  {
+    assert(list->head == NULL);
+    list->pool = pool_init(node_size(list), SLL_POOL_CHUNK_NODES);
+  }
+  /* An unrolled list can also start a fresh block mid-way through. */
+  size_t nodes = is_unrolled(list)?
+                 (n + list->node_capacity - 1) / list->node_capacity + 1 : n;
+  pool_reserve(list->pool, nodes);
+}
+
+void sll_index(sll *list, sll_cmp_fn cmp_fn)
+{
+  assert(list != NULL);
+  assert(cmp_fn != NULL);
+  assert(!is_unrolled(list));
+  if (list->index == NULL)
+  {
+    list->index = skip_init(cmp_fn);
+  }
+  else if (skip_cmp(list->index) != cmp_fn)
+  {
+    skip_free(list->index);
+    list->index = skip_init(cmp_fn);
+  }
+  skip_build(list->index, list->head);
+}
+
+void sll_drop_index(sll *list)
+{
+  assert(list != NULL);
+  drop_index(list);
+}
+
+void sll_build_prefetch(sll *list)
+{
+  assert(list != NULL);
+  if (list->prefetch != SLL_PREFETCH_JUMP) return;
+  /* behind runs prefetch_distance node_ts behind ahead. */
+  node_t *behind = list->head, *ahead = list->head;
+  for (size_t i = 0; i < list->prefetch_distance && ahead != NULL; i++)
+  {
+    ahead = ahead->next;
+  }
+  for (; behind != NULL; behind = behind->next)
+  {
+    /* Only stale pointers are written, to spare clean cache lines. */
+    if (*jump_of(list, behind) != ahead) *jump_of(list, behind) = ahead;
+    if (ahead != NULL) ahead = ahead->next;
+  }
+}
+
 void *sll_search(sll *list, void *elem, sll_cmp_fn cmp_fn)
 {
   assert(list != NULL);
   assert(elem != NULL);
   assert(cmp_fn != NULL);
-  for (node_t *n = list->head; n != NULL; n = n->next)
+  if (indexed_by(list, cmp_fn))
   {
-    if (cmp_fn(n->data, elem) == 0) return n->data;
+    node_t *pred = skip_find_pred(list->index, list->head, elem, false);
+    node_t *n = (pred == NULL)? list->head : pred->next;
+    return (n != NULL && cmp_fn(n->data, elem) == 0)? n->data : NULL;
+  }
+  for (node_t *n = prefetch_ahead(list, list->head); n != NULL;
+       n = prefetch_ahead(list, n->next))
+  {
+    for (size_t i = 0; i < node_count(list, n); i++)
+    {
+      void *data = node_elem(list, n, i);
+      if (cmp_fn(data, elem) == 0) return data;
+    }
   }
   return NULL;
 }
@@ -121,9 +637,23 @@ size_t sll_elem_count(sll *list, void *elem, sll_cmp_fn cmp_fn)
   assert(elem != NULL);
   assert(cmp_fn != NULL);
   size_t elem_count = 0;
-  for (node_t *n = list->head; n != NULL; n = n->next)
+  if (indexed_by(list, cmp_fn))
   {
-    if (cmp_fn(n->data, elem) == 0) elem_count++;
+    node_t *pred = skip_find_pred(list->index, list->head, elem, false);
+    for (node_t *n = (pred == NULL)? list->head : pred->next;
+         n != NULL && cmp_fn(n->data, elem) == 0; n = n->next)
+    {
+      elem_count++;
+    }
+    return elem_count;
+  }
+  for (node_t *n = prefetch_ahead(list, list->head); n != NULL;
+       n = prefetch_ahead(list, n->next))
+  {
+    for (size_t i = 0; i < node_count(list, n); i++)
+    {
+      if (cmp_fn(node_elem(list, n, i), elem) == 0) elem_count++;
+    }
   }
   return elem_count;
 }
@@ -132,9 +662,13 @@ void sll_map(sll *list, sll_map_fn map_fn, void *aux_data)
 {
   assert(list != NULL);
   assert(map_fn != NULL);
-  for (node_t *n = list->head; n != NULL; n = n->next)
+  for (node_t *n = prefetch_ahead(list, list->head); n != NULL;
+       n = prefetch_ahead(list, n->next))
   {
-    map_fn(n->data, aux_data);
+    for (size_t i = 0; i < node_count(list, n); i++)
+    {
+      map_fn(node_elem(list, n, i), aux_data);
+    }
   }
 }
 
@@ -150,35 +684,317 @@ void sll_sorted_insert(sll *list, void *elem, sll_cmp_fn cmp_fn)
   assert(list != NULL);
   assert(elem != NULL);
   assert(cmp_fn != NULL);
-  node_t *n = build_node(elem, list->elem_size);
-  node_t *prev = NULL;
-  for (node_t *cur = list->head; cur != NULL; prev = cur, cur = cur->next)
+  if (indexed_by(list, cmp_fn))
   {
-    if (cmp_fn(cur->data, n->data) > 0) break;
+    node_t *n = build_node(list, elem);
+    link_after(list, skip_insert(list->index, list->head, n), n);
+    list->length++;
+    return;
   }
-  if (prev == NULL)
+  drop_index(list);
+  /* Ascending input goes straight onto the tail. */
+  if (list->tail == NULL ||
+      cmp_fn(node_elem(list, list->tail, node_count(list, list->tail) - 1),
+             elem) <= 0)
   {
-    push(&list->head, n);
+    sll_append(list, elem);
+    return;
   }
-  else
+  list->length++;
+  if (is_unrolled(list))
   {
-    insert_after(prev, n);
+    node_t *cur = list->head;
+    size_t i = 0;
+    /* The tail holds something greater than elem, so this stops. */
+    while (cmp_fn(node_elem(list, cur, i), elem) <= 0)
+    {
+      if (++i == block_of(cur)->count)
+      {
+        cur = cur->next;
+        i = 0;
+      }
+    }
+    block_insert(list, cur, i, elem);
+    return;
+  }
+  node_t *prev = NULL;
+  for (node_t *cur = list->head; cur != NULL; prev = cur, cur = cur->next)
+  {
+    if (cmp_fn(cur->data, elem) > 0) break;
   }
+  link_after(list, prev, build_node(list, elem));
 }
 
 void sll_insert_sort(sll *list, sll_cmp_fn cmp_fn)
 {
   assert(list != NULL);
   assert(cmp_fn != NULL);
-  /* TODO: fix me! */
-  NOT_YET_IMPLEMENTED
-
-  /*node_t *sorted_list = NULL;
-  while (list->head != NULL) {
+  assert(!is_unrolled(list));
+  drop_index(list);
+  node_t *sorted_list = NULL;
+  node_t *sorted_tail = NULL;
+  while (list->head != NULL)
+  {
     node_t *n = pop(&list->head);
-    sorted_insert(&sorted_list, n, cmp_fn);
+    n->next = NULL;
+    /* Appending past the tail keeps already-sorted input linear. */
+    if (sorted_tail == NULL || cmp_fn(n->data, sorted_tail->data) >= 0)
+    {
+      if (sorted_tail == NULL)
+      {
+        sorted_list = n;
+      }
+      else
+      {
+        insert_after(sorted_tail, n);
+      }
+      sorted_tail = n;
+      continue;
+    }
+    /* Goes after every node that compares equal, which keeps it stable. */
+    node_t **link = &sorted_list;
+    while (cmp_fn((*link)->data, n->data) <= 0)
+    {
+      link = &(*link)->next;
+    }
+    push(link, n);
+  }
+  list->head = sorted_list;
+  list->tail = sorted_tail;
+}
+
+/* Whether n's element comes before key in merge order: it compares less,
+ * or no greater if after_equal. */
+static bool goes_before(node_t *n, const void *key, sll_cmp_fn cmp_fn,
+                        bool after_equal)
+{
+  int cmp = cmp_fn(n->data, key);
+  return after_equal? cmp <= 0 : cmp < 0;
+}
+
+/* Returns the last node_t of the sorted chain from n that goes before key,
+ * given that n does. Rather than comparing every node it gallops, probing
+ * 1, 2, 4, 8... nodes further on until it overshoots, then bisects the
+ * last stride: skipping k nodes takes O(log k) comparisons, though still
+ * O(k) hops along the chain. */
+static node_t *gallop(node_t *n, const void *key, sll_cmp_fn cmp_fn,
+                      bool after_equal)
+{
+  for (size_t stride = 1; ; stride *= 2)
+  {
+    node_t *probe = n;
+    size_t steps = 0;
+    while (steps < stride && probe->next != NULL)
+    {
+      probe = probe->next;
+      steps++;
+    }
+    if (steps == 0) return n;
+    if (!goes_before(probe, key, cmp_fn, after_equal))
+    {
+      /* n goes before key and the node steps past it doesn't. */
+      while (steps > 1)
+      {
+        node_t *mid = ith(n, steps / 2);
+        if (goes_before(mid, key, cmp_fn, after_equal))
+        {
+          n = mid;
+          steps -= steps / 2;
+        }
+        else
+        {
+          steps /= 2;
+        }
+      }
+      return n;
+    }
+    n = probe;
+    if (steps < stride) return n;
+  }
+}
+
+/* Merges the sorted, NULL-terminated chains a and b, taking from a on
+ * ties so the merge is stable. Once either side wins MIN_GALLOP times in
+ * a row it gallops to the end of that side's run and moves the run in one
+ * go, so merging chains of very different sizes, or that barely overlap,
+ * takes few comparisons. Returns the head and, if tail isn't NULL, stores
+ * the last node in *tail. */
+static node_t *merge_chains(node_t *a, node_t *b, sll_cmp_fn cmp_fn,
+                            node_t **tail)
+{
+  node_t *head = NULL;
+  node_t **link = &head;
+  node_t *last = NULL;
+  size_t a_wins = 0, b_wins = 0;
+  while (a != NULL && b != NULL)
+  {
+    if (cmp_fn(b->data, a->data) < 0)
+    {
+      a_wins = 0;
+      last = (++b_wins < MIN_GALLOP)? b : gallop(b, a->data, cmp_fn, false);
+      *link = b;
+      b = last->next;
+    }
+    else
+    {
+      b_wins = 0;
+      last = (++a_wins < MIN_GALLOP)? a : gallop(a, b->data, cmp_fn, true);
+      *link = a;
+      a = last->next;
+    }
+    link = &last->next;
+  }
+  *link = (a != NULL)? a : b;
+  if (tail != NULL)
+  {
+    for (node_t *n = *link; n != NULL; n = n->next)
+    {
+      last = n;
+    }
+    *tail = last;
+  }
+  return head;
+}
+
+/* Cuts the run starting at *head off the chain and returns the rest. A
+ * run is the longest non-descending prefix, or the longest strictly
+ * descending one, which is reversed in place (strictly, so equal
+ * elements never swap order). */
+static node_t *cut_run(node_t **head, sll_cmp_fn cmp_fn)
+{
+  node_t *n = *head;
+  if (n->next != NULL && cmp_fn(n->next->data, n->data) < 0)
+  {
+    node_t *run = NULL;
+    node_t *rest = n;
+    do
+    {
+      push(&run, pop(&rest));
+    }
+    while (rest != NULL && cmp_fn(rest->data, run->data) < 0);
+    n->next = NULL;
+    *head = run;
+    return rest;
+  }
+  while (n->next != NULL && cmp_fn(n->next->data, n->data) >= 0)
+  {
+    n = n->next;
+  }
+  node_t *rest = n->next;
+  n->next = NULL;
+  return rest;
+}
+
+/* Natural bottom-up merge sort: each pass merges neighbouring runs in
+ * pairs, so it needs no recursion or scratch memory and runs in one pass
+ * on sorted input. The last node ends up in *tail. */
+static node_t *merge_sort(node_t *head, sll_cmp_fn cmp_fn, node_t **tail)
+{
+  *tail = NULL;
+  if (head == NULL) return NULL;
+  size_t num_merges;
+  do
+  {
+    node_t *sorted = NULL;
+    node_t **link = &sorted;
+    num_merges = 0;
+    while (head != NULL)
+    {
+      node_t *a = head;
+      head = cut_run(&a, cmp_fn);
+      node_t *b = head;
+      if (b != NULL)
+      {
+        head = cut_run(&b, cmp_fn);
+      }
+      *link = merge_chains(a, b, cmp_fn, tail);
+      link = &(*tail)->next;
+      num_merges++;
+    }
+    head = sorted;
+  }
+  while (num_merges > 1);
+  return head;
+}
+
+/* An empty list that stores the same kind of element as list and gets its
+ * node_ts from the same place, so nodes can move between the two. */
+static sll *empty_like(const sll *list)
+{
+  sll *like = sll_init_prefetch(list->elem_size, list->node_capacity,
+                                list->prefetch, list->prefetch_distance,
+                                list->free_fn);
+  if (list->pool != NULL)
+  {
+    sll_use_pool(like, list->pool);
+  }
+  return like;
+}
+
+/* Makes element i start a node_t, splitting its block if need be, and
+ * returns the node before it (NULL if i is 0, the tail if i is the
+ * length). */
+static node_t *boundary(sll *list, size_t i)
+{
+  assert(i <= list->length);
+  if (i == 0) return NULL;
+  if (i == list->length) return list->tail;
+  if (!is_unrolled(list)) return ith(list->head, i - 1);
+  node_t *prev;
+  size_t offset;
+  node_t *n = locate(list, i, &prev, &offset);
+  if (offset == 0) return prev;
+  split_block(list, n, offset);
+  return n;
+}
+
+/* Moves elements i onwards of list onto the end of back. */
+static void move_tail(sll *list, size_t i, sll *back)
+{
+  if (i == list->length) return;
+  node_t *last_kept = boundary(list, i);
+  node_t *first = (last_kept == NULL)? list->head : last_kept->next;
+  splice(back, first, list->tail, list->length - i);
+  if (last_kept == NULL)
+  {
+    list->head = NULL;
+  }
+  else
+  {
+    last_kept->next = NULL;
   }
-  list->head = sorted_list;*/
+  list->tail = last_kept;
+  list->length = i;
+}
+
+sll *sll_detach_range(sll *list, size_t start, size_t count)
+{
+  assert(list != NULL);
+  assert(start + count <= list->length);
+  sll *range = empty_like(list);
+  if (count == 0) return range;
+  drop_index(list);
+  node_t *before = boundary(list, start);
+  node_t *last = boundary(list, start + count);
+  node_t *first = (before == NULL)? list->head : before->next;
+  if (before == NULL)
+  {
+    list->head = last->next;
+  }
+  else
+  {
+    before->next = last->next;
+  }
+  if (last == list->tail) list->tail = before;
+  last->next = NULL;
+  list->length -= count;
+  splice(range, first, last, count);
+  return range;
+}
+
+sll *sll_pop_n(sll *list, size_t n)
+{
+  return sll_detach_range(list, 0, n);
 }
 
 void sll_front_back_split(sll *list, sll *front, sll *back)
@@ -186,49 +1002,112 @@ void sll_front_back_split(sll *list, sll *front, sll *back)
   assert(list != NULL);
   assert(front != NULL);
   assert(back != NULL);
-  /* TODO: fix me! */
-  /*size_t length = sll_length(list);
-  size_t front_length = (length / 2) + (length % 2);
-  *front = list;
-  node_t *front_end = sll_ith(list, front_length - 2);
-  *back = front_end->next;
-  front_end->next = NULL;*/
-  NOT_YET_IMPLEMENTED
+  assert(same_nodes(list, front) && same_nodes(list, back));
+  drop_index(front);
+  drop_index(back);
+  move_tail(list, (list->length + 1) / 2, back);
+  sll_concat(front, list);
+}
+
+/* Unrolled version of sll_remove_duplicates: compacts each block in
+ * place and drops the blocks that end up empty. */
+static void remove_duplicates_unrolled(sll *list, sll_cmp_fn cmp_fn)
+{
+  void *last_kept = NULL;
+  node_t *prev = NULL;
+  node_t *n = list->head;
+  while (n != NULL)
+  {
+    struct block *b = block_of(n);
+    size_t kept = 0;
+    for (size_t i = 0; i < b->count; i++)
+    {
+      void *elem = node_elem(list, n, i);
+      if (last_kept != NULL && cmp_fn(last_kept, elem) == 0)
+      {
+        if (list->free_fn != NULL)
+        {
+          list->free_fn(elem);
+        }
+        continue;
+      }
+      if (kept != i)
+      {
+        memcpy(node_elem(list, n, kept), elem, list->elem_size);
+      }
+      last_kept = node_elem(list, n, kept++);
+    }
+    list->length -= b->count - kept;
+    b->count = kept;
+    node_t *next = n->next;
+    if (kept == 0)
+    {
+      release_node(list, unlink_after(list, prev));
+    }
+    else
+    {
+      prev = n;
+    }
+    n = next;
+  }
 }
 
 void sll_remove_duplicates(sll *list, sll_cmp_fn cmp_fn)
 {
+  assert(list != NULL);
+  assert(cmp_fn != NULL);
+  if (list->head == NULL) return;
+  if (is_unrolled(list))
+  {
+    remove_duplicates_unrolled(list, cmp_fn);
+    return;
+  }
   for (node_t *prev = list->head, *cur = prev->next; cur != NULL;
       cur = prev->next)
   {
     if (cmp_fn(prev->data, cur->data) == 0)
     {
-      remove_after(prev);
+      unlink_after(list, prev);
+      list->length--;
       if (list->free_fn != NULL)
       {
         list->free_fn(cur->data);
       }
+      release_node(list, cur);
     }
     else
     {
       prev = cur;
     }
   }
+  /* Cheaper to rebuild in one pass than to unhook towers one by one. */
+  if (list->index != NULL)
+  {
+    skip_build(list->index, list->head);
+  }
 }
 
 void sll_move_node(sll *dst, sll *src)
 {
   assert(dst != NULL);
   assert(src != NULL);
-  push(&dst->head, pop(&src->head));
+  assert(!is_unrolled(dst) && same_nodes(dst, src));
+  drop_index(dst);
+  drop_index(src);
+  link_after(dst, NULL, unlink_after(src, NULL));
+  dst->length++;
+  src->length--;
 }
 
 void sll_alternating_split(sll *list, sll *a, sll *b)
 {
-  while (list != NULL)
+  assert(list != NULL);
+  assert(a != NULL);
+  assert(b != NULL);
+  while (list->head != NULL)
   {
     sll_move_node(a, list);
-    if (list == NULL) break;
+    if (list->head == NULL) break;
     sll_move_node(b, list);
   }
 }
@@ -240,28 +1119,214 @@ sll *sll_shuffle_merge(sll *a, sll *b)
 
 sll *sll_sorted_merge(sll *a, sll *b, sll_cmp_fn cmp_fn)
 {
-  NOT_YET_IMPLEMENTED
+  assert(a != NULL);
+  assert(b != NULL);
+  assert(cmp_fn != NULL);
+  assert(!is_unrolled(a) && !is_unrolled(b));
+  assert(same_nodes(a, b));
+  drop_index(a);
+  drop_index(b);
+  sll *merged = empty_like(a);
+  merged->head = merge_chains(a->head, b->head, cmp_fn, NULL);
+  /* Ties go to a, so b's tail is last unless a's is strictly greater. */
+  if (a->tail == NULL || (b->tail != NULL &&
+      cmp_fn(a->tail->data, b->tail->data) <= 0))
+  {
+    merged->tail = b->tail;
+  }
+  else
+  {
+    merged->tail = a->tail;
+  }
+  merged->length = a->length + b->length;
+  a->head = a->tail = NULL;
+  a->length = 0;
+  b->head = b->tail = NULL;
+  b->length = 0;
+  return merged;
 }
 
 void sll_merge_sort(sll *list, sll_cmp_fn cmp_fn)
 {
-  NOT_YET_IMPLEMENTED
+  assert(list != NULL);
+  assert(cmp_fn != NULL);
+  assert(!is_unrolled(list));
+  drop_index(list);
+  list->head = merge_sort(list->head, cmp_fn, &list->tail);
+}
+
+/* One input to sll_sorted_merge_all: the rest of lists[i]'s chain. */
+struct source
+{
+  node_t *head;
+  size_t i;
+};
+
+/* Merge order between sources, with ties going to the earlier list. */
+static bool source_before(const struct source *s, const struct source *t,
+                          sll_cmp_fn cmp_fn)
+{
+  return goes_before(s->head, t->head->data, cmp_fn, s->i < t->i);
+}
+
+static void sift_down(struct source *heap, size_t size, size_t i,
+                      sll_cmp_fn cmp_fn)
+{
+  struct source moving = heap[i];
+  for (size_t child; (child = 2 * i + 1) < size; i = child)
+  {
+    if (child + 1 < size &&
+        source_before(&heap[child + 1], &heap[child], cmp_fn))
+    {
+      child++;
+    }
+    if (!source_before(&heap[child], &moving, cmp_fn)) break;
+    heap[i] = heap[child];
+  }
+  heap[i] = moving;
+}
+
+sll *sll_sorted_merge_all(sll *lists[], size_t num_lists, sll_cmp_fn cmp_fn)
+{
+  assert(lists != NULL);
+  assert(num_lists > 0);
+  assert(cmp_fn != NULL);
+  struct source *heap = malloc(num_lists * sizeof(struct source));
+  if (heap == NULL)
+  {
+    fprintf(stderr, "error: sll_sorted_merge_all(): Out of heap memory\n");
+    exit(1);
+  }
+  size_t size = 0;
+  size_t length = 0;
+  for (size_t i = 0; i < num_lists; i++)
+  {
+    assert(!is_unrolled(lists[i]) && same_nodes(lists[0], lists[i]));
+    drop_index(lists[i]);
+    if (lists[i]->head == NULL) continue;
+    heap[size].head = lists[i]->head;
+    heap[size].i = i;
+    size++;
+    length += lists[i]->length;
+  }
+  for (size_t i = size / 2; i > 0; i--)
+  {
+    sift_down(heap, size, i - 1, cmp_fn);
+  }
+
+  sll *merged = empty_like(lists[0]);
+  node_t **link = &merged->head;
+  while (size > 0)
+  {
+    /* Move the top source's whole run up to the runner-up's head. */
+    struct source *top = &heap[0];
+    node_t *last = lists[top->i]->tail;
+    if (size > 1)
+    {
+      struct source *next = (size > 2 &&
+                             source_before(&heap[2], &heap[1], cmp_fn))?
+                            &heap[2] : &heap[1];
+      bool after_equal = top->i < next->i;
+      last = top->head;
+      if (last->next != NULL &&
+          goes_before(last->next, next->head->data, cmp_fn, after_equal))
+      {
+        last = gallop(last->next, next->head->data, cmp_fn, after_equal);
+      }
+    }
+    *link = top->head;
+    link = &last->next;
+    merged->tail = last;
+    top->head = last->next;
+    if (top->head == NULL)
+    {
+      heap[0] = heap[--size];
+    }
+    sift_down(heap, size, 0, cmp_fn);
+  }
+  *link = NULL;
+  merged->length = length;
+  free(heap);
+
+  for (size_t i = 0; i < num_lists; i++)
+  {
+    lists[i]->head = lists[i]->tail = NULL;
+    lists[i]->length = 0;
+  }
+  return merged;
+}
+
+/* Returns the last node_t of list from n on whose element is less than
+ * key, given that n's is: through list's skip index if it was built for
+ * cmp_fn, in O(log length) comparisons and hops, else by galloping. */
+static node_t *seek(const sll *list, node_t *n, const void *key,
+                    sll_cmp_fn cmp_fn)
+{
+  if (indexed_by(list, cmp_fn))
+  {
+    return skip_find_pred(list->index, list->head, key, false);
+  }
+  return gallop(n, key, cmp_fn, false);
 }
 
 sll *sll_sorted_intersect(sll *a, sll *b, sll_cmp_fn cmp_fn)
 {
-  NOT_YET_IMPLEMENTED
+  assert(a != NULL);
+  assert(b != NULL);
+  assert(cmp_fn != NULL);
+  assert(!is_unrolled(a) && !is_unrolled(b));
+  if (!indexed_by(a, cmp_fn)) drop_index(a);
+  sll *common = empty_like(a);
+  node_t *prev = NULL; /* the node before cur in a */
+  node_t *cur = a->head;
+  node_t *other = b->head;
+  while (cur != NULL && other != NULL)
+  {
+    int cmp = cmp_fn(cur->data, other->data);
+    if (cmp < 0)
+    {
+      prev = seek(a, cur, other->data, cmp_fn);
+      cur = prev->next;
+    }
+    else if (cmp > 0)
+    {
+      other = seek(b, other, cur->data, cmp_fn)->next;
+    }
+    else
+    {
+      if (a->index != NULL) skip_remove(a->index, cur);
+      unlink_after(a, prev);
+      a->length--;
+      link_after(common, common->tail, cur);
+      common->length++;
+      cur = (prev == NULL)? a->head : prev->next;
+      other = other->next;
+    }
+  }
+  return common;
 }
 
 void sll_reverse(sll *list)
 {
   assert(list != NULL);
+  drop_index(list);
+  list->tail = list->head;
   node_t *reversed_list = NULL;
   while (list->head != NULL)
   {
     push(&reversed_list, pop(&list->head));
   }
   list->head = reversed_list;
+  if (!is_unrolled(list)) return;
+  for (node_t *n = list->head; n != NULL; n = n->next)
+  {
+    size_t count = block_of(n)->count;
+    for (size_t i = 0; i < count / 2; i++)
+    {
+      swap_elems(node_elem(list, n, i), node_elem(list, n, count - 1 - i),
+                 list->elem_size);
+    }
+  }
 }
 
 void sll_reverse_recursive(sll *list)
@@ -12,6 +12,8 @@
 #include <stdbool.h>
 
 #include "node.h" /* Figure out a good way to forward-declare node_t */
+#include "pool.h"
+#include "skip.h"
 
 #ifndef SLL_H_
 #define SLL_H_
@@ -20,31 +22,143 @@ typedef void (*sll_map_fn)(void *elem, void *aux_data);
 typedef int (*sll_cmp_fn)(const void *a, const void *b);
 typedef void (*sll_free_fn)(void *elem);
 
+/* Chunk size for the pools that sll_reserve creates. */
+#define SLL_POOL_CHUNK_NODES 1024
+
+/* Furthest ahead a list can prefetch; see sll_init_prefetch. */
+#define SLL_MAX_PREFETCH 32
+
+/* How a list's scans prefetch; see sll_init_prefetch. */
+enum sll_prefetch
+{
+  SLL_PREFETCH_NONE,
+  SLL_PREFETCH_AHEAD,
+  SLL_PREFETCH_JUMP
+};
+
 typedef struct
 {
   node_t *head;
+  node_t *tail;
+  size_t length; /* in elements, not node_ts */
   size_t elem_size;
+  size_t node_capacity; /* elements per node_t; 1 unless unrolled */
   sll_free_fn free_fn;
+  pool_t *pool; /* where node_ts come from; NULL means the heap */
+  skip_t *index; /* optional skip-list towers; see sll_index */
+  enum sll_prefetch prefetch; /* how scans prefetch */
+  size_t prefetch_distance; /* node_ts to prefetch ahead in scans */
 }
 sll;
 
+sll *sll_init(size_t elem_size, sll_free_fn free_fn);
+
+/* Creates an unrolled list: each node_t holds a block of up to
+ * elems_per_node contiguous elements plus a count, so scans take one
+ * pointer hop per block instead of one per element. The value-level
+ * API behaves exactly as for a list made with sll_init; the operations
+ * that relink whole node_ts (sll_move_node and friends) are only
+ * supported on plain lists. */
+sll *sll_init_unrolled(size_t elem_size, size_t elems_per_node,
+                       sll_free_fn free_fn);
+
+/* Creates a list (unrolled if elems_per_node > 1) whose sll_map,
+ * sll_search and sll_elem_count prefetch distance node_ts ahead, so they
+ * don't stall on every next pointer:
+ *
+ *   SLL_PREFETCH_AHEAD  guesses where the node_ts ahead are from where
+ *                       a pool (see sll_reserve) or a run of appends puts
+ *                       them: distance slots further on in memory. It
+ *                       also fetches all of the next node_t, which an
+ *                       unrolled list's block gives time to arrive. Costs
+ *                       nothing in memory, but guesses wrong once the
+ *                       links no longer follow the layout.
+ *   SLL_PREFETCH_JUMP   gives each node_t a jump pointer to the node_t
+ *                       distance steps further on, which works however
+ *                       the node_ts are laid out. The pointers are laid
+ *                       by sll_build_prefetch; nothing else writes them,
+ *                       so scans stay read-only. A list that changes
+ *                       afterwards only gets useless prefetches from its
+ *                       stale pointers until it's built again.
+ *
+ * Lists built in order are already covered by the hardware prefetcher;
+ * prefetching pays off once the node_ts are scattered. */
+sll *sll_init_prefetch(size_t elem_size, size_t elems_per_node,
+                       enum sll_prefetch prefetch, size_t distance,
+                       sll_free_fn free_fn);
+
+/* Points every jump pointer of a SLL_PREFETCH_JUMP list at the node_t
+ * distance steps further on, in O(n). Does nothing for other lists. */
+void sll_build_prefetch(sll *list);
+
+/* Allocates the list's node_ts from pool instead of the heap. The pool
+ * may be shared by lists whose nodes fit in its slots (for instance
+ * another list's pool) and is released by sll_free. The list must be
+ * empty. */
+void sll_use_pool(sll *list, pool_t *pool);
+
+/* Makes sure the next n pushes won't call malloc, giving the list a
+ * pool of its own first if it doesn't have one. A list with a private
+ * pool and no free_fn is freed in O(chunks) rather than O(n). */
+void sll_reserve(sll *list, size_t n);
+
 void sll_push(sll *list, void *elem);
+
+/* Adds elem to the end of the list in O(1). */
+void sll_append(sll *list, void *elem);
+
+/* Splices all of src onto the end of dst in O(1) without copying, leaving
+ * src empty. Both lists must have the same kind of nodes, allocated from
+ * the same place. */
+void sll_concat(sll *dst, sll *src);
+
+
+/* Removes the first element and returns a malloc'd copy of it, which the
+ * caller must free. */
 void *sll_pop(sll *list);
+
+/* Removes the first element, copying it into elem (elem_size bytes)
+ * instead of a fresh allocation. Together with a pool (see sll_reserve)
+ * a pop touches no allocator at all. */
+void sll_pop_into(sll *list, void *elem);
+
+/* Cuts count elements starting at index start out of the list and
+ * returns them, in order, as a new list, without copying elements
+ * (except to split a block of an unrolled list at either end). The new
+ * list shares the original's pool, if any. sll_pop_n(list, n) detaches
+ * the first n elements. */
+sll *sll_detach_range(sll *list, size_t start, size_t count);
+sll *sll_pop_n(sll *list, size_t n);
 void *sll_ith(sll *list, int i);
 void sll_insert_ith(sll *list, int i, void *elem);
 void sll_remove_ith(sll *list, int i);
 size_t sll_length(sll *list);
 void sll_free(sll *list);
+
+/* Builds a skip-list index over a plain list that is sorted by cmp_fn.
+ * While the index is up, sll_sorted_insert, sll_search and
+ * sll_elem_count called with the same cmp_fn take expected O(log n)
+ * steps, and pops and removals keep it current. Anything else that
+ * rearranges node_ts (pushes, appends, sorts, splits, merges and so on)
+ * drops the index; call sll_index again to rebuild it in O(n). */
+void sll_index(sll *list, sll_cmp_fn cmp_fn);
+void sll_drop_index(sll *list);
+
 void *sll_search(sll *list, void *elem, sll_cmp_fn cmp_fn);
 size_t sll_elem_count(sll *list, void *elem, sll_cmp_fn cmp_fn);
 void sll_map(sll *list, sll_map_fn map_fn, void *aux_data);
 void sll_bubble_sort(sll *list, sll_cmp_fn cmp_fn);
 void sll_sorted_insert(sll *list, void *elem, sll_cmp_fn cmp_fn);
+
+/* Stable, in-place insertion sort that relinks node_ts. Linear on input
+ * that is already sorted. */
 void sll_insert_sort(sll *list, sll_cmp_fn cmp_fn);
 
 /* Splits a list into two sublists, one for the front half
  * and one for the back half. If the number of elements is
- * odd, then the extra element goes in the front list. */
+ * odd, then the extra element goes in the front list. The
+ * halves are appended to front and back, leaving list empty;
+ * only the front half is walked. */
 void sll_front_back_split(sll *list, sll *front, sll *back);
 
 /* Removes duplicates from a list sorted in increasing
@@ -56,8 +170,31 @@ void sll_remove_duplicates(sll *list, sll_cmp_fn cmp_fn);
 void sll_move_node(sll *dst, sll *src);
 void sll_alternating_split(sll *list, sll *a, sll *b);
 sll *sll_shuffle_merge(sll *a, sll *b);
+
+/* Merges two sorted lists by relinking their node_ts into a new list,
+ * leaving a and b empty. Stable: on ties the element from a comes first.
+ * Both lists must allocate their nodes from the same place. Gallops
+ * through long runs from one side, so merging a short list into a long
+ * one takes few comparisons. */
 sll *sll_sorted_merge(sll *a, sll *b, sll_cmp_fn cmp_fn);
+
+/* Like sll_sorted_merge for num_lists lists at once, in a single pass:
+ * O(n log num_lists) comparisons at worst, fewer when the lists' runs
+ * barely overlap. Ties go to the earlier list. */
+sll *sll_sorted_merge_all(sll *lists[], size_t num_lists, sll_cmp_fn cmp_fn);
+
+/* Stable, in-place natural merge sort. Works bottom-up over the runs
+ * already present in the list, relinking node_ts without recursing or
+ * allocating, in O(n log n) time (O(n) if the list is already sorted or
+ * reverse-sorted). */
 void sll_merge_sort(sll *list, sll_cmp_fn cmp_fn);
+
+/* Moves the elements of sorted list a that also appear in sorted list b
+ * into a new sorted list, relinking a's node_ts; b is left alone. Each
+ * element of b matches at most one of a, so duplicates are kept as many
+ * times as both lists have them. Either list skips ahead by galloping,
+ * or through its skip index (see sll_index) if it has one for cmp_fn, so
+ * intersecting a short list with a long one is cheap. */
 sll *sll_sorted_intersect(sll *a, sll *b, sll_cmp_fn cmp_fn);
 void sll_reverse(sll *list);
 bool sll_has_cycle(sll *list);
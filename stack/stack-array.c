@@ -8,32 +8,94 @@
 
 #include "stack.h"
 
+#include <assert.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+/* Transparent huge pages are this big on x86-64 and most arm64 kernels. */
+#define HUGE_PAGE_SIZE (2 * 1024 * 1024)
+
+/* A reserved stack doesn't bother returning less than this many pages. */
+#define MIN_RELEASE_PAGES 64
+
+#define ROUND_UP(x, a) (((x) + (a) - 1) / (a) * (a))
 
 struct stack
 {
     size_t elem_size;
     size_t num_elems;
-    size_t alloc_size;
+    size_t alloc_size; /* in elements */
     stack_free_fn free_fn;
     void *elems;
+
+    /* For stacks from stack_init_reserved; reserved is 0 otherwise. */
+    size_t reserved; /* bytes of address space mapped at elems */
+    size_t touched; /* bytes from elems that may have pages committed */
+    size_t page_size;
+
+    /* For stacks from stack_init_inline and stack_init_in. */
+    void *inline_elems; /* where elems starts out; NULL if on the heap */
+    bool owns_self; /* false if the caller provided the memory */
 };
 
+typedef char header_fits[(sizeof(stack) <= STACK_HEADER_BYTES)? 1 : -1];
+
 /**
- * "Grows" the stack by doubling its size.
+ * "Grows" the stack by doubling its size, or more if it needs room for
+ * more than that.
  */
-static void grow(stack *s)
+static void grow(stack *s, size_t min_alloc)
 {
-	// TODO: check to see if s->alloc_size <= UINT_MAX?
-	s->alloc_size *= 2;
-	s->elems = realloc(s->elems, s->alloc_size);
-	if (s->elems == NULL)
+	if (s->reserved > 0)
+	{
+		fprintf(stderr, "error: grow(): Reserved space for %zu elements "
+		        "exhausted\n", s->alloc_size);
+		exit(1);
+	}
+	s->alloc_size = (s->alloc_size > SIZE_MAX / 2)? SIZE_MAX
+	                                                : 2 * s->alloc_size;
+	if (s->alloc_size < min_alloc) s->alloc_size = min_alloc;
+	if (s->alloc_size > SIZE_MAX / s->elem_size)
+	{
+		fprintf(stderr, "error: grow(): Stack too large\n");
+		exit(1);
+	}
+	void *elems = (s->elems == s->inline_elems)?
+	              malloc(s->alloc_size * s->elem_size) :
+	              realloc(s->elems, s->alloc_size * s->elem_size);
+	if (elems == NULL)
 	{
 		fprintf(stderr, "error: grow(): Out of heap memory\n");
 		exit(1);
 	}
+	/* Outgrowing the inline space moves the elements to the heap. */
+	if (s->elems == s->inline_elems)
+	{
+		memcpy(elems, s->elems, s->num_elems * s->elem_size);
+	}
+	s->elems = elems;
+}
+
+/**
+ * Hands the pages of a reserved stack back to the kernel once in_use, the
+ * bytes that have to stay readable, is under a quarter of what it has
+ * touched. It keeps twice in_use, so a stack hovering around one size
+ * doesn't fault the same pages in and out.
+ */
+static void maybe_release(stack *s, size_t in_use)
+{
+	if (in_use >= s->touched / 4) return;
+	size_t keep = ROUND_UP(2 * in_use, s->page_size);
+	if (s->touched - keep < MIN_RELEASE_PAGES * (size_t)getpagesize())
+	{
+		return;
+	}
+	madvise((char *)s->elems + keep, s->touched - keep, MADV_DONTNEED);
+	s->touched = keep;
 }
 
 /**
@@ -57,7 +119,8 @@ stack *stack_init(size_t elem_size, size_t init_alloc,
 	s->num_elems = 0;
 	s->alloc_size = (init_alloc == 0)? DEFAULT_ALLOCATION : init_alloc;
 	s->free_fn = free_fn;
-    s->elems = calloc(init_alloc, s->elem_size);
+	s->owns_self = true;
+    s->elems = calloc(s->alloc_size, s->elem_size);
     if (s->elems == NULL)
     {
     	fprintf(stderr, "error: stack_init(): Out of heap memory\n");
@@ -66,18 +129,156 @@ stack *stack_init(size_t elem_size, size_t init_alloc,
     return s;
 }
 
-void stack_push(stack *s, const void *elem)
+stack *stack_init_inline(size_t elem_size, size_t inline_elems,
+                         stack_free_fn free_fn)
+{
+	size_t mem_size = STACK_INLINE_BYTES(elem_size, inline_elems);
+	void *mem = malloc(mem_size);
+	if (mem == NULL)
+	{
+		fprintf(stderr, "error: stack_init_inline(): Out of heap memory\n");
+		exit(1);
+	}
+	stack *s = stack_init_in(mem, mem_size, elem_size, free_fn);
+	s->owns_self = true;
+	return s;
+}
+
+stack *stack_init_in(void *mem, size_t mem_size, size_t elem_size,
+                     stack_free_fn free_fn)
+{
+	assert(mem != NULL);
+	assert((uintptr_t)mem % sizeof(void *) == 0);
+	assert(mem_size >= STACK_HEADER_BYTES);
+	stack *s = memset(mem, 0, sizeof(stack));
+	s->elem_size = elem_size;
+	s->num_elems = 0;
+	s->alloc_size = (mem_size - STACK_HEADER_BYTES) / elem_size;
+	s->free_fn = free_fn;
+	s->inline_elems = (char *)mem + STACK_HEADER_BYTES;
+	s->elems = s->inline_elems;
+	s->owns_self = false;
+	return s;
+}
+
+stack *stack_init_reserved(size_t elem_size, size_t max_elems,
+                           bool huge_pages, stack_free_fn free_fn)
+{
+	stack *s = calloc(1, sizeof(stack));
+	if (s == NULL)
+	{
+		fprintf(stderr, "error: stack_init_reserved(): Out of heap memory\n");
+		exit(1);
+	}
+	s->elem_size = elem_size;
+	s->num_elems = 0;
+	s->alloc_size = (max_elems == 0)? DEFAULT_ALLOCATION : max_elems;
+	s->free_fn = free_fn;
+	s->owns_self = true;
+	s->page_size = getpagesize();
+#ifdef MADV_HUGEPAGE
+	if (huge_pages) s->page_size = HUGE_PAGE_SIZE;
+#endif
+	s->reserved = ROUND_UP(s->alloc_size * elem_size, s->page_size);
+
+	/* Over-reserve by a page so the range can be trimmed to start on a
+	 * page_size boundary, as huge pages need. */
+	size_t slack = s->page_size - getpagesize();
+	char *base = mmap(NULL, s->reserved + slack, PROT_READ | PROT_WRITE,
+	                  MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	if (base == MAP_FAILED)
+	{
+		fprintf(stderr, "error: stack_init_reserved(): Out of address "
+		        "space\n");
+		exit(1);
+	}
+	char *start = (char *)ROUND_UP((uintptr_t)base, s->page_size);
+	if (start > base) munmap(base, start - base);
+	if (slack > (size_t)(start - base))
+	{
+		munmap(start + s->reserved, slack - (start - base));
+	}
+	s->elems = start;
+	s->touched = 0;
+#ifdef MADV_HUGEPAGE
+	if (huge_pages) madvise(s->elems, s->reserved, MADV_HUGEPAGE);
+#endif
+	return s;
+}
+
+/**
+ * Makes room for n more elements and returns the first of them, counting
+ * them as pushed.
+ */
+static void *push_space(stack *s, size_t n)
 {
-	if (s->num_elems == s->alloc_size)
+	if (n > s->alloc_size - s->num_elems)
 	{
-		grow(s);
+		if (n > SIZE_MAX - s->num_elems)
+		{
+			fprintf(stderr, "error: push_space(): Stack too large\n");
+			exit(1);
+		}
+		grow(s, s->num_elems + n);
 	}
-	memcpy(ith_elem(s, s->num_elems++), elem, s->elem_size);
+	void *space = ith_elem(s, s->num_elems);
+	s->num_elems += n;
+	if (s->reserved > 0 && s->num_elems * s->elem_size > s->touched)
+	{
+		s->touched = ROUND_UP(s->num_elems * s->elem_size, s->page_size);
+	}
+	return space;
+}
+
+void stack_push(stack *s, const void *elem)
+{
+	memcpy(push_space(s, 1), elem, s->elem_size);
+}
+
+void stack_push_n(stack *s, const void *elems, size_t n)
+{
+	if (n == 0) return;
+	memcpy(push_space(s, n), elems, n * s->elem_size);
+}
+
+void *stack_push_slot(stack *s)
+{
+	return push_space(s, 1);
+}
+
+void stack_push_commit(stack *s, void *slot)
+{
+	assert(slot == stack_peek(s));
 }
 
 void *stack_pop(stack *s)
 {
-	return ith_elem(s, --s->num_elems);
+	assert(s->num_elems > 0);
+	void *elem = ith_elem(s, --s->num_elems);
+	if (s->reserved > 0)
+	{
+		/* The popped element has to stay readable for the caller. */
+		maybe_release(s, (s->num_elems + 1) * s->elem_size);
+	}
+	return elem;
+}
+
+size_t stack_pop_n(stack *s, void *elems, size_t n)
+{
+	if (n > s->num_elems) n = s->num_elems;
+	s->num_elems -= n;
+	memcpy(elems, ith_elem(s, s->num_elems), n * s->elem_size);
+	if (s->reserved > 0)
+	{
+		maybe_release(s, s->num_elems * s->elem_size);
+	}
+	return n;
+}
+
+void *stack_peek(const stack *s)
+{
+	assert(s->num_elems > 0);
+	return ith_elem(s, s->num_elems - 1);
 }
 
 size_t stack_size(const stack *s)
@@ -94,6 +295,13 @@ void stack_free(stack *s)
 			s->free_fn(ith_elem(s, i));
 		}
 	}
-	free(s->elems);
-	free(s);
+	if (s->reserved > 0)
+	{
+		munmap(s->elems, s->reserved);
+	}
+	else if (s->elems != s->inline_elems)
+	{
+		free(s->elems);
+	}
+	if (s->owns_self) free(s);
 }
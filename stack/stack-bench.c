@@ -0,0 +1,225 @@
+/*************************************************************************
+ * stack-bench.c
+ * ------------
+ * Nate Hardison <natehardison@gmail.com>
+ *
+ * Benchmark harness for the stack backends. Built once per backend
+ * (stack-bench-array, stack-bench-list, ...), it runs the same workloads
+ * for a range of element sizes and init_allocs:
+ *
+ *   push   push n elements onto a new stack
+ *   pop    pop n elements off a full one
+ *   mixed  n random pushes and pops, half and half, from half full
+ *
+ * For each it reports ns per operation, the peak resident set size, and
+ * how many times the stack called the allocator, from stack_init to
+ * stack_free. The calls are counted by linking with -Wl,--wrap for each
+ * allocator function, which only catches calls from our own objects, not
+ * from inside libc. Every case runs in a child process of its own so the
+ * peak RSS of one doesn't hide that of the next.
+ * Usage: stack-bench-array [max_elems]
+ ************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "stack.h"
+
+#define DEFAULT_MAX_ELEMS (1 << 20)
+
+/* Cases with big elements run on fewer of them, to cap memory use. */
+#define MAX_BYTES (64 << 20)
+
+#define MAX_ELEM_SIZE 512
+
+static const size_t elem_sizes[] = { 8, 64, MAX_ELEM_SIZE };
+static const size_t init_allocs[] = { 0, 1024 };
+
+static struct
+{
+	size_t mallocs;
+	size_t callocs;
+	size_t reallocs;
+	size_t frees;
+} calls;
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+void __real_free(void *ptr);
+int __real_posix_memalign(void **ptr, size_t alignment, size_t size);
+
+void *
+__wrap_malloc(size_t size)
+{
+	calls.mallocs++;
+	return __real_malloc(size);
+}
+
+void *
+__wrap_calloc(size_t count, size_t size)
+{
+	calls.callocs++;
+	return __real_calloc(count, size);
+}
+
+void *
+__wrap_realloc(void *ptr, size_t size)
+{
+	calls.reallocs++;
+	return __real_realloc(ptr, size);
+}
+
+void
+__wrap_free(void *ptr)
+{
+	calls.frees++;
+	__real_free(ptr);
+}
+
+int
+__wrap_posix_memalign(void **ptr, size_t alignment, size_t size)
+{
+	calls.mallocs++;
+	return __real_posix_memalign(ptr, alignment, size);
+}
+
+static double
+now()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* Peak resident set size so far, in KB. */
+static long
+peak_rss()
+{
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	return usage.ru_maxrss;
+}
+
+/* Runs one workload on n elements and returns the seconds spent in the
+ * operations it times. */
+static double
+run(const char *workload, size_t elem_size, size_t init_alloc, size_t n)
+{
+	char elem[MAX_ELEM_SIZE];
+	memset(elem, 7, elem_size);
+	stack *s = stack_init(elem_size, init_alloc, NULL);
+	volatile char sink = 0;
+	double start, elapsed;
+
+	if (strcmp(workload, "push") == 0)
+	{
+		start = now();
+		for (size_t i = 0; i < n; i++)
+		{
+			stack_push(s, elem);
+		}
+		elapsed = now() - start;
+	}
+	else if (strcmp(workload, "pop") == 0)
+	{
+		for (size_t i = 0; i < n; i++)
+		{
+			stack_push(s, elem);
+		}
+		start = now();
+		for (size_t i = 0; i < n; i++)
+		{
+			sink += *(char *)stack_pop(s);
+		}
+		elapsed = now() - start;
+	}
+	else
+	{
+		for (size_t i = 0; i < n / 2; i++)
+		{
+			stack_push(s, elem);
+		}
+		unsigned int seed = 2463534242u;
+		start = now();
+		for (size_t i = 0; i < n; i++)
+		{
+			seed ^= seed << 13;
+			seed ^= seed >> 17;
+			seed ^= seed << 5;
+			if ((seed & 1) || stack_size(s) == 0)
+			{
+				stack_push(s, elem);
+			}
+			else
+			{
+				sink += *(char *)stack_pop(s);
+			}
+		}
+		elapsed = now() - start;
+	}
+
+	stack_free(s);
+	(void)sink;
+	return elapsed;
+}
+
+/* Runs and reports one case, in a child process. */
+static void
+report(const char *workload, size_t elem_size, size_t init_alloc,
+       size_t n)
+{
+	fflush(stdout);
+	pid_t pid = fork();
+	if (pid < 0)
+	{
+		fprintf(stderr, "error: report(): Can't fork\n");
+		exit(1);
+	}
+	if (pid > 0)
+	{
+		waitpid(pid, NULL, 0);
+		return;
+	}
+
+	long baseline = peak_rss();
+	memset(&calls, 0, sizeof(calls));
+	double elapsed = run(workload, elem_size, init_alloc, n);
+	printf("%-8s %9zu %10zu %8zu %9.2f %10ld %9zu %9zu %9zu\n", workload,
+	       elem_size, init_alloc, n, elapsed * 1e9 / n,
+	       peak_rss() - baseline, calls.mallocs + calls.callocs,
+	       calls.reallocs, calls.frees);
+	exit(0);
+}
+
+int
+main(int argc, const char *argv[])
+{
+	size_t max_elems = (argc > 1)? strtoul(argv[1], NULL, 10)
+	                             : DEFAULT_MAX_ELEMS;
+	const char *workloads[] = { "push", "pop", "mixed" };
+
+	printf("%-8s %9s %10s %8s %9s %10s %9s %9s %9s\n", "workload",
+	       "elem_size", "init_alloc", "n", "ns/op", "rss KB", "allocs",
+	       "reallocs", "frees");
+	for (size_t w = 0; w < sizeof(workloads) / sizeof(*workloads); w++)
+	{
+		for (size_t e = 0; e < sizeof(elem_sizes) / sizeof(*elem_sizes); e++)
+		{
+			size_t n = MAX_BYTES / elem_sizes[e];
+			if (n > max_elems) n = max_elems;
+			for (size_t i = 0;
+			     i < sizeof(init_allocs) / sizeof(*init_allocs); i++)
+			{
+				report(workloads[w], elem_sizes[e], init_allocs[i], n);
+			}
+		}
+	}
+
+	return 0;
+}
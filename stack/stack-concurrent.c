@@ -0,0 +1,504 @@
+/*************************************************************************
+ * stack-concurrent.c
+ * ------------
+ * Nate Hardison <natehardison@gmail.com>
+ *
+ * Implementation of a thread-safe generic stack container that many
+ * threads can push to and pop from at once. Elements live in nodes on a
+ * lock-free (Treiber) stack: the top is a pointer and a counter swapped
+ * together with one double-width compare-and-swap, so a thread whose
+ * view of the top went stale (even one that was popped and pushed back)
+ * fails its CAS and retries instead of corrupting the stack.
+ *
+ * Under contention every thread hammers the same top, so a thread whose
+ * CAS fails backs off to an elimination array: a push offers its node in
+ * a random slot for a short while, and a pop that finds an offer takes it.
+ * The two cancel out without either touching the top, which lets the
+ * stack scale where a lock, or the bare Treiber stack, would serialize.
+ *
+ * Nodes are never returned to the heap while the stack lives, only to a
+ * free list of its own, so a thread reading a node another thread has
+ * just popped never reads freed memory.
+ ************************************************************************/
+
+#include "stack.h"
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CACHE_LINE 64
+
+/* Slots in the elimination array, and how long a push waits in one. */
+#define ELIM_SLOTS 16
+#define ELIM_SPINS 64
+
+/* Nodes are allocated this many at a time. */
+#define CHUNK_NODES 256
+
+/* Nodes are rounded up to a multiple of this, which keeps every node,
+ * and so every element, pointer-aligned. */
+#define NODE_ALIGN sizeof(void *)
+
+#define ROUND_UP(x, a) (((x) + (a) - 1) / (a) * (a))
+
+struct node
+{
+    struct node *next;
+    char elem[];
+};
+
+/* A node pointer and a counter bumped by every change to it. */
+struct tagged
+{
+    struct node *ptr;
+    uintptr_t tag;
+};
+
+/* Where the compiler can inline a double-width CAS (cmpxchg16b, with
+ * -mcx16 on x86-64) a tagged pointer is swapped as one integer.
+ * Otherwise the generic __atomic calls go through libatomic. */
+#ifdef __GCC_HAVE_SYNC_COMPARE_AND_SWAP_16
+#define INLINE_DWCAS
+__extension__ typedef unsigned __int128 dword_t;
+#else
+typedef struct tagged dword_t;
+#endif
+
+union word
+{
+    struct tagged tagged;
+    dword_t raw;
+};
+
+/* A tagged pointer on a cache line of its own, so threads working on
+ * one don't slow down threads working on another. */
+struct line
+{
+    union word word;
+} __attribute__((aligned(CACHE_LINE)));
+
+/* Chunks of nodes, freed with the stack. */
+struct chunk
+{
+    struct chunk *next;
+};
+
+struct stack
+{
+    struct line top;
+    struct line free_nodes;
+    struct line elim[ELIM_SLOTS];
+    struct
+    {
+        intptr_t n; /* may dip below 0 while pushes and pops race */
+    } __attribute__((aligned(CACHE_LINE))) size;
+
+    size_t elem_size;
+    size_t node_size;
+    stack_free_fn free_fn;
+    pthread_key_t held; /* each thread's held node (see stack_pop) */
+    pthread_mutex_t chunk_lock;
+    struct chunk *chunks;
+};
+
+/* Per-thread xorshift state for picking elimination slots. */
+static __thread unsigned int seed;
+
+static void cpu_relax(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_ia32_pause();
+#endif
+}
+
+/* Reads a tagged pointer one word at a time. The halves may be torn, but
+ * a torn read simply makes the following CAS fail. */
+static struct tagged load(union word *w)
+{
+	struct tagged t;
+	t.ptr = __atomic_load_n(&w->tagged.ptr, __ATOMIC_ACQUIRE);
+	t.tag = __atomic_load_n(&w->tagged.tag, __ATOMIC_RELAXED);
+	return t;
+}
+
+/* Swaps in (ptr, tag) if w still holds *old; otherwise stores what it
+ * found in *old. */
+static bool cas(union word *w, struct tagged *old, struct node *ptr,
+                uintptr_t tag)
+{
+	union word expected = { *old }, desired = { { ptr, tag } };
+#ifdef INLINE_DWCAS
+	union word found;
+	found.raw = __sync_val_compare_and_swap(&w->raw, expected.raw,
+	                                        desired.raw);
+	if (found.raw == expected.raw) return true;
+	*old = found.tagged;
+	return false;
+#else
+	return __atomic_compare_exchange(&w->tagged, old, &desired.tagged,
+	                                 false, __ATOMIC_ACQ_REL,
+	                                 __ATOMIC_ACQUIRE);
+#endif
+}
+
+/* One attempt at pushing the chain first..last; false if another thread
+ * got in first. */
+static bool try_push(union word *w, struct node *first, struct node *last)
+{
+	struct tagged old = load(w);
+	__atomic_store_n(&last->next, old.ptr, __ATOMIC_RELAXED);
+	return cas(w, &old, first, old.tag + 1);
+}
+
+static void push_chain(union word *w, struct node *first, struct node *last)
+{
+	while (!try_push(w, first, last))
+	{
+		cpu_relax();
+	}
+}
+
+/* One attempt at popping: returns the node, or NULL with *empty set if
+ * there was nothing to pop and clear if another thread got in first. */
+static struct node *try_pop(union word *w, bool *empty)
+{
+	struct tagged old = load(w);
+	*empty = (old.ptr == NULL);
+	if (old.ptr == NULL) return NULL;
+	/* old.ptr may already be popped; then the CAS below fails. */
+	struct node *next = __atomic_load_n(&old.ptr->next, __ATOMIC_RELAXED);
+	return cas(w, &old, next, old.tag + 1)? old.ptr : NULL;
+}
+
+/* One attempt at popping up to n nodes at once: returns how many, with
+ * the chain in *first..*last, or -1 if another thread got in first. The
+ * top's tag changes with every push and pop, so as long as it reads the
+ * same, the nodes walked so far are still the top of the stack. */
+static intptr_t try_pop_chain(union word *w, size_t n, struct node **first,
+                              struct node **last)
+{
+	struct tagged old;
+	old.tag = __atomic_load_n(&w->tagged.tag, __ATOMIC_ACQUIRE);
+	old.ptr = __atomic_load_n(&w->tagged.ptr, __ATOMIC_ACQUIRE);
+	struct node *rest = old.ptr;
+	size_t count = 0;
+	while (rest != NULL && count < n)
+	{
+		*last = rest;
+		rest = __atomic_load_n(&rest->next, __ATOMIC_ACQUIRE);
+		count++;
+		/* Stop as soon as the stack changes under us, rather than
+		 * follow nodes that may have moved elsewhere. */
+		if (__atomic_load_n(&w->tagged.tag, __ATOMIC_ACQUIRE) != old.tag)
+		{
+			return -1;
+		}
+	}
+	*first = old.ptr;
+	if (count == 0) return 0;
+	return cas(w, &old, rest, old.tag + 1)? (intptr_t)count : -1;
+}
+
+static union word *random_slot(stack *s)
+{
+	if (seed == 0) seed = (unsigned int)(uintptr_t)&seed | 1;
+	seed ^= seed << 13;
+	seed ^= seed >> 17;
+	seed ^= seed << 5;
+	return &s->elim[seed % ELIM_SLOTS].word;
+}
+
+/* Offers n in a random slot of the elimination array for a while; true
+ * if a pop took it, false if the push has to go back to the top. */
+static bool eliminate_push(stack *s, struct node *n)
+{
+	union word *slot = random_slot(s);
+	struct tagged offer = load(slot);
+	if (offer.ptr != NULL || !cas(slot, &offer, n, offer.tag + 1))
+	{
+		return false;
+	}
+	offer.ptr = n;
+	offer.tag++;
+	for (int i = 0; i < ELIM_SPINS; i++)
+	{
+		if (__atomic_load_n(&slot->tagged.tag, __ATOMIC_ACQUIRE) !=
+		    offer.tag)
+		{
+			return true;
+		}
+		cpu_relax();
+	}
+	/* Withdraw the offer, unless a pop takes it first. */
+	return !cas(slot, &offer, NULL, offer.tag + 1);
+}
+
+/* Takes a push's offer from a random slot, if there is one. */
+static struct node *eliminate_pop(stack *s)
+{
+	union word *slot = random_slot(s);
+	struct tagged offer = load(slot);
+	if (offer.ptr == NULL || !cas(slot, &offer, NULL, offer.tag + 1))
+	{
+		return NULL;
+	}
+	return offer.ptr;
+}
+
+/* Links count nodes carved out of mem onto the free list. */
+static void add_nodes(stack *s, char *mem, size_t count)
+{
+	if (count == 0) return;
+	struct node *first = (struct node *)mem;
+	struct node *last = first;
+	for (size_t i = 1; i < count; i++)
+	{
+		struct node *n = (struct node *)(mem + i * s->node_size);
+		last->next = n;
+		last = n;
+	}
+	push_chain(&s->free_nodes.word, first, last);
+}
+
+static void add_chunk(stack *s, size_t count)
+{
+	size_t header = ROUND_UP(sizeof(struct chunk), NODE_ALIGN);
+	struct chunk *chunk = malloc(header + count * s->node_size);
+	if (chunk == NULL)
+	{
+		fprintf(stderr, "error: add_chunk(): Out of heap memory\n");
+		exit(1);
+	}
+	pthread_mutex_lock(&s->chunk_lock);
+	chunk->next = s->chunks;
+	s->chunks = chunk;
+	pthread_mutex_unlock(&s->chunk_lock);
+	add_nodes(s, (char *)chunk + header, count);
+}
+
+/* Hands back the node a thread held when it exits. A held node is on no
+ * list, so its next field names its stack instead. The stack is still
+ * there, since stack_free deletes the key, which stops this being
+ * called. */
+static void release_held(void *held)
+{
+	struct node *n = held;
+	stack *s = (stack *)n->next;
+	push_chain(&s->free_nodes.word, n, n);
+}
+
+static struct node *alloc_node(stack *s)
+{
+	struct node *held = pthread_getspecific(s->held);
+	if (held != NULL)
+	{
+		pthread_setspecific(s->held, NULL);
+		return held;
+	}
+	bool empty;
+	for (;;)
+	{
+		struct node *n = try_pop(&s->free_nodes.word, &empty);
+		if (n != NULL) return n;
+		if (empty) add_chunk(s, CHUNK_NODES);
+	}
+}
+
+static void push_node(stack *s, struct node *n)
+{
+	while (!try_push(&s->top.word, n, n))
+	{
+		if (eliminate_push(s, n)) return;
+	}
+	__atomic_add_fetch(&s->size.n, 1, __ATOMIC_RELAXED);
+}
+
+/* Returns the popped node, or NULL if the stack was empty. */
+static struct node *pop_node(stack *s)
+{
+	bool empty;
+	for (;;)
+	{
+		struct node *n = try_pop(&s->top.word, &empty);
+		if (n != NULL)
+		{
+			__atomic_sub_fetch(&s->size.n, 1, __ATOMIC_RELAXED);
+			return n;
+		}
+		if (empty) return NULL;
+		n = eliminate_pop(s);
+		if (n != NULL) return n;
+	}
+}
+
+stack *stack_init(size_t elem_size, size_t init_alloc,
+                  stack_free_fn free_fn)
+{
+	stack *s;
+	if (posix_memalign((void **)&s, CACHE_LINE, sizeof(stack)) != 0)
+	{
+		fprintf(stderr, "error: stack_init(): Out of heap memory\n");
+		exit(1);
+	}
+	memset(s, 0, sizeof(stack));
+	s->elem_size = elem_size;
+	s->node_size = ROUND_UP(sizeof(struct node) + elem_size, NODE_ALIGN);
+	s->free_fn = free_fn;
+	if (pthread_key_create(&s->held, release_held) != 0)
+	{
+		fprintf(stderr, "error: stack_init(): Too many stacks\n");
+		exit(1);
+	}
+	pthread_mutex_init(&s->chunk_lock, NULL);
+	s->chunks = NULL;
+	if (init_alloc > 0) add_chunk(s, init_alloc);
+	return s;
+}
+
+stack *stack_init_reserved(size_t elem_size, size_t max_elems,
+                           bool huge_pages, stack_free_fn free_fn)
+{
+	return stack_init(elem_size, 0, free_fn);
+}
+
+stack *stack_init_inline(size_t elem_size, size_t inline_elems,
+                         stack_free_fn free_fn)
+{
+	return stack_init(elem_size, inline_elems, free_fn);
+}
+
+stack *stack_init_in(void *mem, size_t mem_size, size_t elem_size,
+                     stack_free_fn free_fn)
+{
+	assert(mem != NULL);
+	assert((uintptr_t)mem % sizeof(void *) == 0);
+	assert(mem_size >= STACK_HEADER_BYTES);
+	/* The stack itself is too big to fit, but mem can hold its first
+	 * nodes (fewer than STACK_INLINE_BYTES promises, if they're many). */
+	stack *s = stack_init(elem_size, 0, free_fn);
+	add_nodes(s, mem, mem_size / s->node_size);
+	return s;
+}
+
+void stack_push(stack *s, const void *elem)
+{
+	struct node *n = alloc_node(s);
+	memcpy(n->elem, elem, s->elem_size);
+	push_node(s, n);
+}
+
+void stack_push_n(stack *s, const void *elems, size_t n)
+{
+	if (n == 0) return;
+	/* Build the batch as a chain, top last, and push it in one go. */
+	struct node *first = NULL, *last = NULL;
+	for (size_t i = 0; i < n; i++)
+	{
+		struct node *node = alloc_node(s);
+		memcpy(node->elem, (const char *)elems + i * s->elem_size,
+		       s->elem_size);
+		node->next = first;
+		first = node;
+		if (last == NULL) last = node;
+	}
+	push_chain(&s->top.word, first, last);
+	__atomic_add_fetch(&s->size.n, n, __ATOMIC_RELAXED);
+}
+
+/* The node stays off the stack until it's committed, so that no other
+ * thread can pop it before the caller has filled it in. */
+void *stack_push_slot(stack *s)
+{
+	return alloc_node(s)->elem;
+}
+
+void stack_push_commit(stack *s, void *slot)
+{
+	push_node(s, (struct node *)((char *)slot - offsetof(struct node, elem)));
+}
+
+/* stack_pop returns a pointer into the popped node, so each thread holds
+ * on to the last node it popped from a stack until its next push or pop
+ * there. A push reuses it, as the array stack reuses the slot it just
+ * popped. The node is kept under the stack's own thread-specific key, so
+ * a thread moving elements between stacks holds one node in each, and
+ * never has to hand a node back to any stack but the one it's calling.
+ * Keys are a limited resource: at most PTHREAD_KEYS_MAX stacks can be
+ * live at once. */
+void *stack_pop(stack *s)
+{
+	struct node *n = pop_node(s);
+	struct node *held = pthread_getspecific(s->held);
+	if (held != NULL)
+	{
+		push_chain(&s->free_nodes.word, held, held);
+	}
+	if (n != NULL)
+	{
+		/* For release_held. Stale pops may still be reading next. */
+		__atomic_store_n(&n->next, (struct node *)s, __ATOMIC_RELAXED);
+	}
+	pthread_setspecific(s->held, n);
+	return (n == NULL)? NULL : n->elem;
+}
+
+size_t stack_pop_n(stack *s, void *elems, size_t n)
+{
+	/* Unlink the whole batch with one CAS, then copy it out in place. */
+	struct node *first, *last;
+	intptr_t count;
+	while ((count = try_pop_chain(&s->top.word, n, &first, &last)) < 0)
+	{
+		cpu_relax();
+	}
+	if (count == 0) return 0;
+	__atomic_sub_fetch(&s->size.n, count, __ATOMIC_RELAXED);
+
+	/* Pops land back to front, since the top of the stack goes last. */
+	struct node *node = first;
+	for (intptr_t i = count - 1; i >= 0; i--, node = node->next)
+	{
+		memcpy((char *)elems + i * s->elem_size, node->elem, s->elem_size);
+	}
+	push_chain(&s->free_nodes.word, first, last);
+	return count;
+}
+
+/* Only good while no other thread is using the stack (see stack.h): the
+ * node may be popped and reused as soon as it's been read. */
+void *stack_peek(const stack *s)
+{
+	struct node *top = __atomic_load_n(&s->top.word.tagged.ptr,
+	                                   __ATOMIC_ACQUIRE);
+	assert(top != NULL);
+	return top->elem;
+}
+
+size_t stack_size(const stack *s)
+{
+	intptr_t n = __atomic_load_n(&s->size.n, __ATOMIC_RELAXED);
+	return (n < 0)? 0 : (size_t)n;
+}
+
+void stack_free(stack *s)
+{
+	pthread_key_delete(s->held);
+	if (s->free_fn != NULL)
+	{
+		for (struct node *n = s->top.word.tagged.ptr; n != NULL; n = n->next)
+		{
+			s->free_fn(n->elem);
+		}
+	}
+	for (struct chunk *chunk = s->chunks, *next; chunk != NULL; chunk = next)
+	{
+		next = chunk->next;
+		free(chunk);
+	}
+	pthread_mutex_destroy(&s->chunk_lock);
+	free(s);
+}
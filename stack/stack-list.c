@@ -3,23 +3,81 @@
  * ------------
  * Nate Hardison <natehardison@gmail.com>
  *
- * Implementation of a singly-linked list-based generic stack container.
+ * Implementation of a segmented generic stack container: a singly-linked
+ * list of fixed-size arrays of elements, newest on top. Pushes never
+ * copy the elements already on the stack (worst-case O(1), no realloc),
+ * elements never move, and within a segment the stack is as cache
+ * friendly as an array.
  ************************************************************************/
 
 #include "stack.h"
 
+#include <assert.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+/* Segments hold at least this many bytes of elements. */
+#define SEGMENT_BYTES 4096
+
+struct segment
+{
+    struct segment *below;
+    char elems[];
+};
+
 struct stack
 {
     size_t elem_size;
     size_t num_elems;
+    size_t seg_capacity; /* elements per segment */
     stack_free_fn free_fn;
-    void *elems; // TODO: use sll library
+    struct segment *top;
+    size_t top_count; /* elements in the top segment */
+
+    /* The last segment to empty, kept so a stack going back and forth
+     * across a segment boundary doesn't malloc and free on every step. */
+    struct segment *spare;
+
+    /* For stacks from stack_init_inline and stack_init_in: the bottom
+     * segment lives in the same memory as the stack and may be a
+     * different size. */
+    struct segment *inline_seg; /* NULL if there isn't one */
+    size_t inline_capacity;
+    bool owns_self; /* false if the caller provided the memory */
 };
 
+typedef char header_fits[(sizeof(stack) + sizeof(struct segment) <=
+                          STACK_HEADER_BYTES)? 1 : -1];
+
+static void *seg_elem(const stack *s, struct segment *seg, size_t i)
+{
+	return seg->elems + i * s->elem_size;
+}
+
+static size_t capacity_of(const stack *s, const struct segment *seg)
+{
+	return (seg == s->inline_seg)? s->inline_capacity : s->seg_capacity;
+}
+
+static struct segment *new_segment(stack *s)
+{
+	struct segment *seg = s->spare;
+	if (seg != NULL)
+	{
+		s->spare = NULL;
+		return seg;
+	}
+	seg = malloc(sizeof(struct segment) + s->seg_capacity * s->elem_size);
+	if (seg == NULL)
+	{
+		fprintf(stderr, "error: new_segment(): Out of heap memory\n");
+		exit(1);
+	}
+	return seg;
+}
+
 stack *stack_init(size_t elem_size, size_t init_alloc,
                   stack_free_fn free_fn)
 {
@@ -31,19 +89,167 @@ stack *stack_init(size_t elem_size, size_t init_alloc,
     }
     s->elem_size = elem_size;
     s->num_elems = 0;
+    s->seg_capacity = (init_alloc == 0)? DEFAULT_ALLOCATION : init_alloc;
+    if (s->seg_capacity < SEGMENT_BYTES / elem_size)
+    {
+        s->seg_capacity = SEGMENT_BYTES / elem_size;
+    }
     s->free_fn = free_fn;
-    s->elems = NULL;
+    s->top = NULL;
+    s->top_count = 0;
+    s->spare = NULL;
+    s->inline_seg = NULL;
+    s->owns_self = true;
     return s;
 }
 
+stack *stack_init_inline(size_t elem_size, size_t inline_elems,
+                         stack_free_fn free_fn)
+{
+	size_t mem_size = STACK_INLINE_BYTES(elem_size, inline_elems);
+	void *mem = malloc(mem_size);
+	if (mem == NULL)
+	{
+		fprintf(stderr, "error: stack_init_inline(): Out of heap memory\n");
+		exit(1);
+	}
+	stack *s = stack_init_in(mem, mem_size, elem_size, free_fn);
+	s->owns_self = true;
+	return s;
+}
+
+stack *stack_init_in(void *mem, size_t mem_size, size_t elem_size,
+                     stack_free_fn free_fn)
+{
+	assert(mem != NULL);
+	assert((uintptr_t)mem % sizeof(void *) == 0);
+	assert(mem_size >= STACK_HEADER_BYTES);
+	stack *s = mem;
+	s->elem_size = elem_size;
+	s->num_elems = 0;
+	s->seg_capacity = SEGMENT_BYTES / elem_size;
+	if (s->seg_capacity < DEFAULT_ALLOCATION)
+	{
+		s->seg_capacity = DEFAULT_ALLOCATION;
+	}
+	s->free_fn = free_fn;
+	s->spare = NULL;
+	s->owns_self = false;
+	/* The segment's elements start right after the header bytes. */
+	s->inline_capacity = (mem_size - STACK_HEADER_BYTES) / elem_size;
+	s->inline_seg = (s->inline_capacity == 0)? NULL :
+	    (struct segment *)((char *)mem + STACK_HEADER_BYTES -
+	                       sizeof(struct segment));
+	if (s->inline_seg != NULL) s->inline_seg->below = NULL;
+	s->top = s->inline_seg;
+	s->top_count = 0;
+	return s;
+}
+
+stack *stack_init_reserved(size_t elem_size, size_t max_elems,
+                           bool huge_pages, stack_free_fn free_fn)
+{
+    return stack_init(elem_size, 0, free_fn);
+}
+
+/**
+ * Makes sure the top segment has room for another element.
+ */
+static void ensure_room(stack *s)
+{
+	if (s->top == NULL || s->top_count == capacity_of(s, s->top))
+	{
+		struct segment *seg = new_segment(s);
+		seg->below = s->top;
+		s->top = seg;
+		s->top_count = 0;
+	}
+}
+
+/**
+ * Makes sure the top segment has an element in it. An emptied segment
+ * stays on top until a pop needs to look below it, so the element the
+ * last pop returned is still readable.
+ */
+static void ensure_elem(stack *s)
+{
+	if (s->top_count == 0)
+	{
+		struct segment *empty = s->top;
+		s->top = empty->below;
+		s->top_count = capacity_of(s, s->top);
+		free(s->spare);
+		s->spare = empty;
+	}
+}
+
 void stack_push(stack *s, const void *elem)
 {
-	// TODO: use sll library!
+	memcpy(stack_push_slot(s), elem, s->elem_size);
+}
+
+void stack_push_n(stack *s, const void *elems, size_t n)
+{
+	const char *next = elems;
+	while (n > 0)
+	{
+		ensure_room(s);
+		size_t run = capacity_of(s, s->top) - s->top_count;
+		if (run > n) run = n;
+		memcpy(seg_elem(s, s->top, s->top_count), next, run * s->elem_size);
+		s->top_count += run;
+		s->num_elems += run;
+		next += run * s->elem_size;
+		n -= run;
+	}
+}
+
+void *stack_push_slot(stack *s)
+{
+	ensure_room(s);
+	s->num_elems++;
+	return seg_elem(s, s->top, s->top_count++);
+}
+
+void stack_push_commit(stack *s, void *slot)
+{
+	assert(slot == stack_peek(s));
 }
 
 void *stack_pop(stack *s)
 {
-	return NULL;
+	assert(s->num_elems > 0);
+	ensure_elem(s);
+	s->num_elems--;
+	return seg_elem(s, s->top, --s->top_count);
+}
+
+size_t stack_pop_n(stack *s, void *elems, size_t n)
+{
+	if (n > s->num_elems) n = s->num_elems;
+	/* Fill elems from the back, since the top of the stack goes last. */
+	for (size_t left = n; left > 0; )
+	{
+		ensure_elem(s);
+		size_t run = (s->top_count < left)? s->top_count : left;
+		s->top_count -= run;
+		left -= run;
+		memcpy((char *)elems + left * s->elem_size,
+		       seg_elem(s, s->top, s->top_count), run * s->elem_size);
+	}
+	s->num_elems -= n;
+	return n;
+}
+
+void *stack_peek(const stack *s)
+{
+	assert(s->num_elems > 0);
+	if (s->top_count == 0)
+	{
+		struct segment *below = s->top->below;
+		return seg_elem(s, below, capacity_of(s, below) - 1);
+	}
+	return seg_elem(s, s->top, s->top_count - 1);
 }
 
 size_t stack_size(const stack *s)
@@ -53,5 +259,20 @@ size_t stack_size(const stack *s)
 
 void stack_free(stack *s)
 {
-    // TODO
+	size_t count = s->top_count;
+	for (struct segment *seg = s->top, *below; seg != NULL; seg = below)
+	{
+		if (s->free_fn != NULL)
+		{
+			for (size_t i = 0; i < count; i++)
+			{
+				s->free_fn(seg_elem(s, seg, i));
+			}
+		}
+		below = seg->below;
+		if (seg != s->inline_seg) free(seg);
+		count = capacity_of(s, below);
+	}
+	free(s->spare);
+	if (s->owns_self) free(s);
 }
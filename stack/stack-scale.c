@@ -0,0 +1,173 @@
+/*************************************************************************
+ * stack-scale.c
+ * ------------
+ * Nate Hardison <natehardison@gmail.com>
+ *
+ * Scaling benchmark for sharing one stack between threads. Every thread
+ * pushes or pops at random, half and half, as fast as it can, for 1, 2,
+ * 4... up to max_threads threads. Built twice: against stack-concurrent.c,
+ * and with -DLOCKED against stack-array.c with every call under one
+ * mutex. Afterward it checks that every element pushed was popped or is
+ * still on the stack.
+ * Usage: stack-scale-concurrent [max_threads] [ops_per_thread]
+ ************************************************************************/
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "stack.h"
+
+#define DEFAULT_MAX_THREADS 8
+#define DEFAULT_OPS_PER_THREAD 1000000
+#define PREFILL 1024
+
+#ifdef LOCKED
+#define BACKEND "stack-array + mutex"
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+#else
+#define BACKEND "stack-concurrent"
+#endif
+
+struct worker
+{
+	pthread_t thread;
+	stack *s;
+	size_t ops;
+	unsigned int seed;
+	long pushed; /* sum of the values pushed, less those popped */
+};
+
+static void
+push(stack *s, long value)
+{
+#ifdef LOCKED
+	pthread_mutex_lock(&lock);
+	stack_push(s, &value);
+	pthread_mutex_unlock(&lock);
+#else
+	stack_push(s, &value);
+#endif
+}
+
+/* Pops into *value; false if the stack was empty. */
+static bool
+pop(stack *s, long *value)
+{
+#ifdef LOCKED
+	pthread_mutex_lock(&lock);
+	bool popped = stack_size(s) > 0;
+	if (popped) *value = *(long *)stack_pop(s);
+	pthread_mutex_unlock(&lock);
+	return popped;
+#else
+	long *elem = stack_pop(s);
+	if (elem != NULL) *value = *elem;
+	return elem != NULL;
+#endif
+}
+
+static void *
+work(void *aux_data)
+{
+	struct worker *w = aux_data;
+	for (size_t i = 0; i < w->ops; i++)
+	{
+		w->seed ^= w->seed << 13;
+		w->seed ^= w->seed >> 17;
+		w->seed ^= w->seed << 5;
+		long value;
+		if (w->seed & 1)
+		{
+			value = w->seed >> 1;
+			push(w->s, value);
+			w->pushed += value;
+		}
+		else if (pop(w->s, &value))
+		{
+			w->pushed -= value;
+		}
+	}
+	return NULL;
+}
+
+static double
+now()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void
+run(size_t num_threads, size_t ops_per_thread)
+{
+	stack *s = stack_init(sizeof(long), 0, NULL);
+	long expected = 0;
+	for (long i = 0; i < PREFILL; i++)
+	{
+		push(s, i);
+		expected += i;
+	}
+
+	struct worker *workers = calloc(num_threads, sizeof(struct worker));
+	if (workers == NULL)
+	{
+		fprintf(stderr, "error: run(): Out of heap memory\n");
+		exit(1);
+	}
+	double start = now();
+	for (size_t i = 0; i < num_threads; i++)
+	{
+		workers[i].s = s;
+		workers[i].ops = ops_per_thread;
+		workers[i].seed = 2463534242u + i;
+		if (pthread_create(&workers[i].thread, NULL, work, &workers[i]) != 0)
+		{
+			fprintf(stderr, "error: run(): Can't create thread\n");
+			exit(1);
+		}
+	}
+	for (size_t i = 0; i < num_threads; i++)
+	{
+		pthread_join(workers[i].thread, NULL);
+		expected += workers[i].pushed;
+	}
+	double elapsed = now() - start;
+
+	long value;
+	while (pop(s, &value))
+	{
+		expected -= value;
+	}
+	if (expected != 0)
+	{
+		fprintf(stderr, "error: run(): Elements lost or duplicated\n");
+		exit(1);
+	}
+	printf("%7zu %12.2f\n", num_threads,
+	       num_threads * ops_per_thread / elapsed / 1e6);
+	free(workers);
+	stack_free(s);
+}
+
+int
+main(int argc, const char *argv[])
+{
+	size_t max_threads = (argc > 1)? strtoul(argv[1], NULL, 10)
+	                               : DEFAULT_MAX_THREADS;
+	size_t ops_per_thread = (argc > 2)? strtoul(argv[2], NULL, 10)
+	                                  : DEFAULT_OPS_PER_THREAD;
+
+	printf("%s, %zu random pushes and pops per thread\n\n", BACKEND,
+	       ops_per_thread);
+	printf("%7s %12s\n", "threads", "Mops/s");
+	for (size_t n = 1; n <= max_threads; n *= 2)
+	{
+		run(n, ops_per_thread);
+	}
+
+	return 0;
+}
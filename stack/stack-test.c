@@ -1,13 +1,336 @@
 #include <stdlib.h>
 #include <stdio.h>
+#include <assert.h>
+#include <malloc.h>
+#include <stdbool.h>
 
 #include "stack.h"
 
 int _main(int argc, const char *argv[]){ return 1; }
 
+static void
+test_push_pop(stack *s, size_t num_elems)
+{
+	for (size_t i = 0; i < num_elems; i++)
+	{
+		stack_push(s, &i);
+		assert(stack_size(s) == i + 1);
+	}
+	for (size_t i = num_elems; i > 0; i--)
+	{
+		assert(*(size_t *)stack_pop(s) == i - 1);
+		assert(stack_size(s) == i - 1);
+	}
+}
+
+static void
+test_stack_init()
+{
+	printf("Testing stack_init()\n--------------------\n");
+
+	printf("Checking growth from the default allocation...");
+	stack *s = stack_init(sizeof(size_t), 0, NULL);
+	test_push_pop(s, 1000);
+	stack_free(s);
+	printf("OK!\n");
+
+	printf("Checking growth from a small allocation...");
+	s = stack_init(sizeof(size_t), 3, NULL);
+	test_push_pop(s, 100000);
+	stack_free(s);
+	printf("OK!\n");
+
+	printf("All good with stack_init()!\n\n");
+}
+
+static void
+test_stack_init_reserved()
+{
+	printf("Testing stack_init_reserved()\n-----------------------------\n");
+
+	for (int huge_pages = 0; huge_pages <= 1; huge_pages++)
+	{
+		printf("Checking that elements never move (huge pages %s)...",
+		       huge_pages? "on" : "off");
+		size_t max_elems = 1 << 20;
+		stack *s = stack_init_reserved(sizeof(size_t), max_elems,
+		                               huge_pages, NULL);
+		size_t zero = 0;
+		stack_push(s, &zero);
+		size_t *bottom = stack_pop(s);
+		stack_push(s, &zero);
+		for (size_t i = 1; i < max_elems; i++)
+		{
+			stack_push(s, &i);
+		}
+		assert(*bottom == 0);
+		test_push_pop(s, 0);
+		printf("OK!\n");
+
+		printf("Checking that a drained stack still works...");
+		while (stack_size(s) > 1)
+		{
+			size_t top = stack_size(s) - 1;
+			assert(*(size_t *)stack_pop(s) == top);
+		}
+		assert(stack_pop(s) == bottom && *bottom == 0);
+		test_push_pop(s, max_elems);
+		stack_free(s);
+		printf("OK!\n");
+	}
+
+	printf("All good with stack_init_reserved()!\n\n");
+}
+
+static void
+test_stack_init_inline()
+{
+	printf("Testing stack_init_inline() and stack_init_in()\n"
+	       "-----------------------------------------------\n");
+
+	printf("Checking a stack that stays inline and one that doesn't...");
+	stack *s = stack_init_inline(sizeof(size_t), 12, NULL);
+	test_push_pop(s, 12);
+	test_push_pop(s, 5000);
+	stack_free(s);
+	printf("OK!\n");
+
+	printf("Checking a stack in caller memory...");
+	union
+	{
+		char bytes[STACK_INLINE_BYTES(sizeof(size_t), 16)];
+		void *align;
+	} mem;
+	s = stack_init_in(&mem, sizeof(mem), sizeof(size_t), NULL);
+	test_push_pop(s, 16);
+	size_t *first = stack_push_slot(s);
+	assert((char *)first >= mem.bytes &&
+	       (char *)first < mem.bytes + sizeof(mem));
+	stack_push_commit(s, first);
+	stack_pop(s);
+	test_push_pop(s, 5000);
+	stack_free(s);
+	printf("OK!\n");
+
+	printf("Checking caller memory with no room for elements...");
+	s = stack_init_in(&mem, STACK_HEADER_BYTES, sizeof(size_t), NULL);
+	test_push_pop(s, 100);
+	stack_free(s);
+	printf("OK!\n");
+
+	printf("All good with stack_init_inline() and stack_init_in()!\n\n");
+}
+
+static void
+test_boundaries()
+{
+	printf("Testing pushes and pops around the same size\n"
+	       "--------------------------------------------\n");
+
+	stack *s = stack_init(sizeof(size_t), 0, NULL);
+	for (size_t size = 1; size < 3000; size += 7)
+	{
+		for (size_t i = stack_size(s); i < size; i++)
+		{
+			stack_push(s, &i);
+		}
+		for (int wobble = 0; wobble < 3; wobble++)
+		{
+			size_t top = size - 1;
+			assert(*(size_t *)stack_pop(s) == top);
+			stack_push(s, &top);
+		}
+		assert(stack_size(s) == size);
+	}
+	while (stack_size(s) > 0)
+	{
+		size_t top = stack_size(s) - 1;
+		assert(*(size_t *)stack_pop(s) == top);
+	}
+	stack_free(s);
+
+	printf("All good with pushes and pops around the same size!\n\n");
+}
+
+static void
+test_push_n_pop_n()
+{
+	printf("Testing stack_push_n() and stack_pop_n()\n"
+	       "----------------------------------------\n");
+
+	size_t batch[3000];
+	for (size_t i = 0; i < 3000; i++)
+	{
+		batch[i] = i;
+	}
+
+	printf("Checking batches of every size...");
+	stack *s = stack_init(sizeof(size_t), 0, NULL);
+	for (size_t n = 0; n <= 3000; n += 37)
+	{
+		stack_push_n(s, batch, n);
+		assert(stack_size(s) == n);
+		if (n > 0) assert(*(size_t *)stack_peek(s) == n - 1);
+		size_t out[3000];
+		assert(stack_pop_n(s, out, n) == n);
+		for (size_t i = 0; i < n; i++)
+		{
+			assert(out[i] == i);
+		}
+	}
+	printf("OK!\n");
+
+	printf("Checking single and batched calls interleave...");
+	size_t zero = 0;
+	stack_push(s, &zero);
+	stack_push_n(s, batch + 1, 1999);
+	stack_push_n(s, batch + 2000, 1000);
+	size_t out[3000];
+	assert(stack_pop_n(s, out, 10) == 10);
+	for (size_t i = 0; i < 10; i++)
+	{
+		assert(out[i] == 2990 + i);
+	}
+	assert(*(size_t *)stack_pop(s) == 2989);
+	assert(stack_pop_n(s, out, 5000) == 2989);
+	for (size_t i = 0; i < 2989; i++)
+	{
+		assert(out[i] == i);
+	}
+	assert(stack_size(s) == 0);
+	assert(stack_pop_n(s, out, 1) == 0);
+	stack_free(s);
+	printf("OK!\n");
+
+	printf("All good with stack_push_n() and stack_pop_n()!\n\n");
+}
+
+struct frame
+{
+	size_t depth;
+	char scratch[200];
+};
+
+static void
+test_push_slot()
+{
+	printf("Testing stack_push_slot() and stack_peek()\n"
+	       "------------------------------------------\n");
+
+	stack *s = stack_init(sizeof(struct frame), 0, NULL);
+	for (size_t i = 0; i < 1000; i++)
+	{
+		struct frame *f = stack_push_slot(s);
+		f->depth = i;
+		f->scratch[199] = (char)i;
+		stack_push_commit(s, f);
+		assert(stack_peek(s) == f);
+	}
+	for (size_t i = 1000; i > 0; i--)
+	{
+		struct frame *top = stack_peek(s);
+		assert(top->depth == i - 1 && top->scratch[199] == (char)(i - 1));
+		assert(stack_pop(s) == top);
+	}
+	stack_free(s);
+
+	printf("All good with stack_push_slot() and stack_peek()!\n\n");
+}
+
+/* Bytes of heap in use, as far as malloc knows. */
+static size_t
+heap_in_use()
+{
+	struct mallinfo2 info = mallinfo2();
+	return info.uordblks + info.hblkhd;
+}
+
+/* Moves one element from a to b and back, rounds times. */
+static void
+move_between(stack *a, stack *b, size_t rounds)
+{
+	for (size_t i = 0; i < rounds; i++)
+	{
+		size_t elem = *(size_t *)stack_pop(a);
+		stack_push(b, &elem);
+		elem = *(size_t *)stack_pop(b);
+		stack_push(a, &elem);
+	}
+}
+
+static void
+test_move_between_stacks()
+{
+	printf("Testing moves between stacks\n"
+	       "----------------------------\n");
+
+	printf("Checking that moving an element back and forth costs no memory...");
+	stack *a = stack_init(sizeof(size_t), 0, NULL);
+	stack *b = stack_init(sizeof(size_t), 0, NULL);
+	size_t elem = 42;
+	stack_push(a, &elem);
+	move_between(a, b, 1000);
+	size_t before = heap_in_use();
+	move_between(a, b, 200000);
+	assert(heap_in_use() < before + 64 * 1024);
+	assert(stack_size(a) == 1 && stack_size(b) == 0);
+	assert(*(size_t *)stack_peek(a) == 42);
+	stack_free(b);
+	printf("OK!\n");
+
+	printf("Checking a stack freed while a node of its is held...");
+	b = stack_init(sizeof(size_t), 0, NULL);
+	stack_push(b, &elem);
+	assert(*(size_t *)stack_pop(b) == 42);
+	stack_free(b);
+	assert(*(size_t *)stack_pop(a) == 42);
+	stack_free(a);
+	printf("OK!\n");
+
+	printf("All good with moves between stacks!\n\n");
+}
+
+static void
+free_int_ptr(void *elem)
+{
+	free(*(int **)elem);
+}
+
+static void
+test_stack_free()
+{
+	printf("Testing stack_free()\n--------------------\n");
+
+	stack *s = stack_init(sizeof(int *), 0, free_int_ptr);
+	for (int i = 0; i < 5000; i++)
+	{
+		int *p = malloc(sizeof(int));
+		assert(p != NULL);
+		*p = i;
+		stack_push(s, &p);
+	}
+	for (int i = 4999; i >= 2500; i--)
+	{
+		int *p = *(int **)stack_pop(s);
+		assert(*p == i);
+		free(p);
+	}
+	stack_free(s);
+
+	printf("All good with stack_free()!\n\n");
+}
+
 int
 main(int argc, const char *argv[])
 {
-	
+	test_stack_init();
+	test_stack_init_reserved();
+	test_stack_init_inline();
+	test_boundaries();
+	test_push_n_pop_n();
+	test_push_slot();
+	test_move_between_stacks();
+	test_stack_free();
+
 	return 0;
 }
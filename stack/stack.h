@@ -9,10 +9,25 @@
 #ifndef _STACK_H
 #define _STACK_H
 
+#include <stdbool.h>
 #include <stddef.h>
 
 #define DEFAULT_ALLOCATION 10
 
+/**
+ * Bytes at the start of the memory given to stack_init_in that the stack
+ * keeps for itself, whichever implementation is in use. The rest holds
+ * elements.
+ */
+#define STACK_HEADER_BYTES 128
+
+/**
+ * Bytes of memory stack_init_in needs to hold n elements of elem_size
+ * without touching the heap.
+ */
+#define STACK_INLINE_BYTES(elem_size, n) \
+    (STACK_HEADER_BYTES + (size_t)(elem_size) * (n))
+
 typedef void (*stack_free_fn)(void *elem);
 
 /**
@@ -38,6 +53,42 @@ typedef struct stack stack;
 stack *stack_init(size_t elem_size, size_t init_alloc,
                   stack_free_fn free_fn);
 
+/**
+ * Initializes a stack that can hold up to max_elems elements without
+ * ever moving them. Rather than allocating a buffer and reallocating it
+ * as it fills, the array-based stack reserves address space for all
+ * max_elems up front and lets the kernel commit pages as pushes first
+ * touch them. Pushes never copy the stack, and pointers to elements stay
+ * valid until they are popped. When the stack drains far below what it
+ * has touched, the unused pages are handed back with madvise. Setting
+ * huge_pages asks for transparent huge pages, where the system has them.
+ *
+ * Pushing more than max_elems elements is a fatal error. Reserving costs
+ * address space, not memory, so max_elems can be generous. The list-based
+ * stack never moves its elements anyway; there this is just stack_init.
+ */
+stack *stack_init_reserved(size_t elem_size, size_t max_elems,
+                           bool huge_pages, stack_free_fn free_fn);
+
+/**
+ * Initializes a stack whose first inline_elems elements live in the
+ * stack object itself, so creating it costs one allocation rather than
+ * two. Elements only go to a separate heap buffer once the stack
+ * outgrows the inline space.
+ */
+stack *stack_init_inline(size_t elem_size, size_t inline_elems,
+                         stack_free_fn free_fn);
+
+/**
+ * Initializes a stack in mem, mem_size bytes of memory that the caller
+ * provides (for instance a local array declared with STACK_INLINE_BYTES),
+ * so a short-lived stack needn't touch the heap at all unless it
+ * outgrows mem. mem must be aligned for a pointer and for the elements,
+ * and must outlive the stack. stack_free doesn't free mem itself.
+ */
+stack *stack_init_in(void *mem, size_t mem_size, size_t elem_size,
+                     stack_free_fn free_fn);
+
 /**
  * Puts a new element on the top of the stack.
  */
@@ -49,6 +100,46 @@ void stack_push(stack *s, const void *elem);
  */
 void *stack_pop(stack *s);
 
+/**
+ * Pushes the n elements stored back to back at elems, so that the last
+ * one ends up on top. Costs one copy per contiguous run of storage rather
+ * than a call per element.
+ */
+void stack_push_n(stack *s, const void *elems, size_t n);
+
+/**
+ * Pops up to n elements into elems, the buffer of at least n elements
+ * that the caller provides, and returns how many it popped. They land in
+ * stack order: the old top is last, so stack_push_n puts them back as
+ * they were. Like stack_pop, the elements become the caller's.
+ */
+size_t stack_pop_n(stack *s, void *elems, size_t n);
+
+/**
+ * Reserves an uninitialized element and returns its slot for the caller
+ * to fill in, so a large element can be built in place rather than built
+ * elsewhere and copied in. The element is only pushed once the filled-in
+ * slot is handed to stack_push_commit, which must come before the
+ * thread's next call on the stack.
+ */
+void *stack_push_slot(stack *s);
+
+/**
+ * Pushes the element in slot, which stack_push_slot returned, once the
+ * caller has filled it in. The array and list stacks have already pushed
+ * it and only check that it's on top; the concurrent stack keeps it from
+ * other threads until now, so they never pop it half built.
+ */
+void stack_push_commit(stack *s, void *slot);
+
+/**
+ * Returns the element on the top of the stack, leaving it there. The
+ * stack must not be empty. With the concurrent stack, the element is only
+ * safe to read while no other thread is using the stack, since another
+ * thread's pop can take it and reuse its memory at any moment.
+ */
+void *stack_peek(const stack *s);
+
 /**
  * Returns the current size of the stack.
  */